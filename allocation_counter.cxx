@@ -0,0 +1,85 @@
+#include "allocation_counter.hxx"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<uint64_t> allocationCount = 0;
+thread_local uint64_t threadAllocationCount = 0;
+
+void countAllocation()
+{
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	++threadAllocationCount;
+}
+
+void *allocate(std::size_t size)
+{
+	countAllocation();
+	return std::malloc(size != 0 ? size : 1);
+}
+
+void *allocateAligned(std::size_t size, std::align_val_t alignment)
+{
+	countAllocation();
+	auto const align = static_cast<std::size_t>(alignment);
+	// aligned_alloc wants a multiple of the alignment
+	return std::aligned_alloc(align, (std::max<std::size_t>(size, 1) + align - 1) / align * align);
+}
+
+void *allocateOrThrow(std::size_t size)
+{
+	void *memory = allocate(size);
+	if (memory == nullptr) {
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void *allocateAlignedOrThrow(std::size_t size, std::align_val_t alignment)
+{
+	void *memory = allocateAligned(size, alignment);
+	if (memory == nullptr) {
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+} // namespace
+
+uint64_t heapAllocations()
+{
+	return allocationCount.load(std::memory_order_relaxed);
+}
+
+uint64_t threadHeapAllocations()
+{
+	return threadAllocationCount;
+}
+
+// clang-format off
+void *operator new(std::size_t size) { return allocateOrThrow(size); }
+void *operator new[](std::size_t size) { return allocateOrThrow(size); }
+void *operator new(std::size_t size, std::nothrow_t const &) noexcept { return allocate(size); }
+void *operator new[](std::size_t size, std::nothrow_t const &) noexcept { return allocate(size); }
+void *operator new(std::size_t size, std::align_val_t alignment) { return allocateAlignedOrThrow(size, alignment); }
+void *operator new[](std::size_t size, std::align_val_t alignment) { return allocateAlignedOrThrow(size, alignment); }
+void *operator new(std::size_t size, std::align_val_t alignment, std::nothrow_t const &) noexcept { return allocateAligned(size, alignment); }
+void *operator new[](std::size_t size, std::align_val_t alignment, std::nothrow_t const &) noexcept { return allocateAligned(size, alignment); }
+
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete[](void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void *memory, std::size_t) noexcept { std::free(memory); }
+void operator delete(void *memory, std::nothrow_t const &) noexcept { std::free(memory); }
+void operator delete[](void *memory, std::nothrow_t const &) noexcept { std::free(memory); }
+void operator delete(void *memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void *memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete(void *memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void *memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+void operator delete(void *memory, std::align_val_t, std::nothrow_t const &) noexcept { std::free(memory); }
+void operator delete[](void *memory, std::align_val_t, std::nothrow_t const &) noexcept { std::free(memory); }
+// clang-format on
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstdint>
+
+// Calls to operator new in the whole program so far. Counted by replacement allocation functions in
+// allocation_counter.cxx, which are linked into any program that calls this; memory zlib and the C library get
+// from malloc() directly is not included.
+uint64_t heapAllocations();
+// The calls made by the calling thread so far
+uint64_t threadHeapAllocations();
@@ -0,0 +1,111 @@
+#include "batch_validator.hxx"
+
+#include "thread_pool.hxx"
+#include "vcf_validation.hxx"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <string_view>
+
+namespace {
+
+// Runs validate with diagnostics() of this thread going to the result
+void validateCaptured(std::string const &file, ThreadPool *pool,
+	std::function<bool(std::string const &, ThreadPool *)> const &validate, BatchResult &result)
+{
+	std::ostringstream messages;
+	auto const start = std::chrono::steady_clock::now();
+	{
+		DiagnosticsRedirect redirect(messages);
+		try {
+			result.valid = validate(file, pool);
+		} catch (std::exception const &e) {
+			diagnostics() << "Failed to validate file: " << file << ": " << e.what() << '\n';
+			result.valid = false;
+		}
+	}
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	result.messages = std::move(messages).str();
+}
+
+} // namespace
+
+bool readBatchList(std::string const &listFile, std::vector<std::string> &files)
+{
+	std::ifstream in(listFile);
+	if (!in.is_open()) {
+		std::cerr << "Failed to open file: " << listFile << '\n';
+		return false;
+	}
+	std::string line;
+	while (std::getline(in, line)) {
+		if (line.ends_with('\r')) {
+			line.pop_back();
+		}
+		if (!line.empty()) {
+			files.push_back(line);
+		}
+	}
+	return true;
+}
+
+std::vector<BatchResult> validateBatch(std::span<std::string const> files, ThreadPool &pool, uint64_t largeFileSize,
+	std::function<bool(std::string const &, ThreadPool *)> const &validate)
+{
+	std::vector<BatchResult> results(files.size());
+	for (size_t i = 0; i < files.size(); ++i) {
+		std::error_code error;
+		uint64_t const size = std::filesystem::file_size(files[i], error);
+		results[i].bytes = error ? 0 : size;
+	}
+
+	// Largest first, so the long files do not end up running alone at the end
+	std::vector<size_t> order(files.size());
+	std::iota(order.begin(), order.end(), size_t {0});
+	std::ranges::stable_sort(order, std::ranges::greater(), [&results](size_t i) { return results[i].bytes; });
+	auto const firstSmall = std::ranges::find_if(order, [&](size_t i) { return results[i].bytes < largeFileSize; });
+
+	std::mutex mutex;
+	std::condition_variable finished;
+	size_t remaining = static_cast<size_t>(order.end() - firstSmall);
+	for (auto it = firstSmall; it != order.end(); ++it) {
+		pool.submit([&, i = *it] {
+			validateCaptured(files[i], nullptr, validate, results[i]);
+			std::lock_guard lock(mutex);
+			if (--remaining == 0) {
+				finished.notify_all();
+			}
+		});
+	}
+	for (auto it = order.begin(); it != firstSmall; ++it) {
+		validateCaptured(files[*it], &pool, validate, results[*it]);
+	}
+
+	std::unique_lock lock(mutex);
+	finished.wait(lock, [&remaining] { return remaining == 0; });
+	return results;
+}
+
+void printBatchSummary(std::ostream &out, std::span<std::string const> files, std::span<BatchResult const> results)
+{
+	auto const flags = out.flags();
+	out << std::fixed << std::setprecision(3);
+	out << "status\tseconds\tbytes\tfile\tmessage\n";
+	for (size_t i = 0; i < files.size(); ++i) {
+		BatchResult const &result = results[i];
+		std::string_view message = result.messages;
+		message = message.substr(0, message.find('\n'));
+		out << (result.valid ? "valid" : "invalid") << '\t' << result.seconds << '\t' << result.bytes << '\t'
+			<< files[i] << '\t' << (result.valid ? std::string_view() : message) << '\n';
+	}
+	out.flags(flags);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <span>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+struct BatchResult {
+	bool valid = false;
+	// What validating the file printed to diagnostics(): its errors or why it could not be read
+	std::string messages;
+	double seconds = 0;
+	// Size on disk, 0 if it could not be determined
+	uint64_t bytes = 0;
+};
+
+// Appends the file names listed in listFile, one per line, skipping empty lines
+bool readBatchList(std::string const &listFile, std::vector<std::string> &files);
+
+// Validates every file with validate(fileName, pool). Files smaller than largeFileSize are each validated whole
+// by one worker of pool, with a null pool so they stay on that worker. The larger ones are validated one after
+// another on the calling thread, meanwhile handing their blocks to pool, where idle workers take them up between
+// the small files. Results are in the order of files.
+std::vector<BatchResult> validateBatch(std::span<std::string const> files, ThreadPool &pool, uint64_t largeFileSize,
+	std::function<bool(std::string const &, ThreadPool *)> const &validate);
+
+// Tab-separated table with a header row and a row per file: status, seconds, bytes, file name and the first message
+// of a file that failed
+void printBatchSummary(std::ostream &out, std::span<std::string const> files, std::span<BatchResult const> results);
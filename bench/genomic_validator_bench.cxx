@@ -0,0 +1,429 @@
+#include "bench/synthetic_vcf.hxx"
+#include "block_reader.hxx"
+#include "decompressor.hxx"
+#include "delimiter_scan.hxx"
+#include "error_sink.hxx"
+#include "header_model.hxx"
+#include "info_checks.hxx"
+#include "parallel_validator.hxx"
+#include "record_order.hxx"
+#include "thread_pool.hxx"
+#include "vcf_validation.hxx"
+#include "vcf_validator.hxx"
+
+#include <algorithm>
+#include <optional>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <zlib.h>
+
+namespace {
+
+// The std::regex matcher isValidAlt() used before the hand-written scanner, kept as the baseline
+bool isValidAltRegex(std::string_view alt)
+{
+	static std::regex const altRegex("^([ACGTN*]+|<[^>]+>)(,[ACGTN*]+|,<[^>]+>)*$");
+	return std::regex_match(alt.cbegin(), alt.cend(), altRegex);
+}
+
+// A mix resembling a WGS call set: mostly SNVs, some indels, multi-allelics, symbolic and invalid alleles
+constexpr std::string_view altSamples[] = {
+	"A",
+	"G",
+	"T",
+	"C",
+	"AT",
+	"A,T",
+	"GTTTTTTTTTTT",
+	"<DEL>",
+	"<INS:ME:ALU>",
+	"*",
+	"C,*",
+	"ACGTACGTACGTACGTACGTACGTACGTACGT,A",
+	"G,<NON_REF>",
+	".",
+	"a",
+	"A,,T",
+};
+
+template<bool (*Matcher)(std::string_view)>
+void BM_altMatcher(benchmark::State &state)
+{
+	size_t bytes = 0;
+	for (auto _ : state) {
+		for (auto alt : altSamples) {
+			benchmark::DoNotOptimize(Matcher(alt));
+			bytes += alt.size();
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * std::size(altSamples));
+	state.SetBytesProcessed(bytes);
+}
+
+constexpr std::string_view genotypeSamples[] = {
+	"0/1",
+	"1|1",
+	"0/0",
+	"./.",
+	"1/2",
+	"0",
+	"10/11",
+	"0/1/2",
+	"x/1",
+};
+
+// Lines of every kind validateHeaderLine() dispatches on
+constexpr std::string_view headerSamples[] = {
+	"##fileformat=VCFv4.2",
+	"##contig=<ID=chr1,length=248956422>",
+	"##INFO=<ID=DP,Number=1,Type=Integer,Description=\"Total Depth\">",
+	"##FORMAT=<ID=AD,Number=R,Type=Integer,Description=\"Allelic depths\">",
+	"##FILTER=<ID=q10,Description=\"Quality below 10\">",
+	"##ALT=<ID=DEL,Description=\"Deletion\">",
+	"##SAMPLE=<ID=S1>",
+	"##source=genomic_validator_bench",
+};
+
+// Header and body of a synthetic file, generated once per shape
+struct SyntheticInput {
+	std::string text;
+	HeaderModel header;
+	std::string_view body;
+	std::vector<std::string_view> dataLines;
+	size_t records = 0;
+};
+
+SyntheticInput makeInput(size_t records, size_t samples, size_t infoFields)
+{
+	SyntheticInput input;
+	input.records = records;
+	input.text = makeSyntheticVcf({.records = records, .samples = samples, .infoFields = infoFields});
+	auto const bodyStart = input.text.find("\n#CHROM");
+	forEachLine(std::string_view(input.text).substr(0, bodyStart), [&input](std::string_view line) {
+		return validateHeaderLine(line, &input.header);
+	});
+	input.body = std::string_view(input.text).substr(input.text.find('\n', bodyStart + 1) + 1);
+	forEachLine(input.body, [&input](std::string_view line) {
+		input.dataLines.push_back(line);
+		return true;
+	});
+	return input;
+}
+
+// Samples per data line come from the first benchmark argument
+std::string_view dataLine(benchmark::State const &state)
+{
+	static std::vector<std::pair<size_t, SyntheticInput>> inputs;
+	auto const samples = static_cast<size_t>(state.range(0));
+	for (auto const &[count, input] : inputs) {
+		if (count == samples) {
+			return input.dataLines.front();
+		}
+	}
+	return inputs.emplace_back(samples, makeInput(1, samples, 4)).second.dataLines.front();
+}
+
+void BM_split(benchmark::State &state)
+{
+	std::string_view const line = dataLine(state);
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(split(line, '\t'));
+	}
+	state.SetBytesProcessed(state.iterations() * line.size());
+}
+
+void BM_splitFields(benchmark::State &state)
+{
+	std::string_view const line = dataLine(state);
+	std::vector<std::string_view> fields;
+	for (auto _ : state) {
+		splitFields<'\t'>(line, fields);
+		benchmark::DoNotOptimize(fields.data());
+	}
+	state.SetBytesProcessed(state.iterations() * line.size());
+}
+
+void BM_isValidGenotype(benchmark::State &state)
+{
+	for (auto _ : state) {
+		for (auto gt : genotypeSamples) {
+			benchmark::DoNotOptimize(isValidGenotype(gt));
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * std::size(genotypeSamples));
+}
+
+// REF allele of state.range(0) bases, the long ones as written for structural variants
+void BM_isValidBase(benchmark::State &state)
+{
+	std::string ref;
+	for (int64_t i = 0; i < state.range(0); ++i) {
+		ref += "ACGTacgtN"[i % 9];
+	}
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(isValidBase(ref));
+	}
+	state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+void BM_isNonNegativeInteger(benchmark::State &state)
+{
+	constexpr std::string_view values[] = {"0", "7", "42", "1234", "99999", "2147483647", "-0", "12345678901"};
+	for (auto _ : state) {
+		for (auto value : values) {
+			benchmark::DoNotOptimize(isNonNegativeInteger(value));
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * std::size(values));
+}
+
+void BM_checkFormatAndSamples(benchmark::State &state)
+{
+	size_t const formatIndex = 8;
+	std::string_view const line = dataLine(state);
+	std::vector<std::string_view> fields;
+	splitFields<'\t'>(line, fields, formatIndex + 2);
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(checkFormatAndSamples(fields, formatIndex));
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+	state.SetBytesProcessed(state.iterations() * fields.back().size());
+}
+
+// Samples per data line, of which only the middle one is checked (--samples)
+void BM_checkFormatAndSamplesSubset(benchmark::State &state)
+{
+	size_t const formatIndex = 8;
+	auto const sampleCount = static_cast<size_t>(state.range(0));
+	std::string_view const line = dataLine(state);
+	std::vector<std::string_view> fields;
+	splitFields<'\t'>(line, fields, formatIndex + 2);
+	HeaderModel header;
+	header.setSampleSelection({.names = {"S" + std::to_string(sampleCount / 2)}});
+	std::vector<std::string> names;
+	for (size_t i = 0; i < sampleCount; ++i) {
+		names.push_back("S" + std::to_string(i));
+	}
+	header.setSamples(std::move(names));
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(checkFormatAndSamples(fields, formatIndex, &header));
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+	state.SetBytesProcessed(state.iterations() * fields.back().size());
+}
+
+// A multi-allelic record's samples, first argument samples per record; with the second argument 1 they are checked
+// against the header, which adds the Number=R count check of AD
+void BM_checkFormatAndSamplesMultiAllelic(benchmark::State &state)
+{
+	size_t const formatIndex = 8;
+	SyntheticInput const input = makeInput(100, static_cast<size_t>(state.range(0)), 4);
+	std::vector<std::string_view> fields;
+	auto const line = std::ranges::find_if(input.dataLines, [&fields](std::string_view dataLine) {
+		splitFields<'\t'>(dataLine, fields, formatIndex + 2);
+		return countAltAlleles(fields[4]) > 1;
+	});
+	if (line == input.dataLines.end()) {
+		state.SkipWithError("no multi-allelic record");
+		return;
+	}
+	HeaderModel const *header = state.range(1) != 0 ? &input.header : nullptr;
+	uint32_t const altAlleles = countAltAlleles(fields[4]);
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(checkFormatAndSamples(fields, formatIndex, header, altAlleles));
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+	state.SetBytesProcessed(state.iterations() * fields.back().size());
+}
+
+void BM_checkDataLines(benchmark::State &state)
+{
+	std::string_view const line = dataLine(state);
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(checkDataLines(line));
+	}
+	state.SetItemsProcessed(state.iterations());
+	state.SetBytesProcessed(state.iterations() * line.size());
+}
+
+// Samples per data line, then the ValidationProfile
+void BM_checkDataLinesProfile(benchmark::State &state)
+{
+	std::string_view const line = dataLine(state);
+	auto const profile = static_cast<ValidationProfile>(state.range(1));
+	state.SetLabel(std::string(profileName(profile)));
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(checkDataLines(line, nullptr, nullptr, profile));
+	}
+	state.SetItemsProcessed(state.iterations());
+	state.SetBytesProcessed(state.iterations() * line.size());
+}
+
+// INFO columns of synthetic records checked against their ##INFO lines, the argument is entries per record
+void BM_checkInfoField(benchmark::State &state)
+{
+	SyntheticInput const input = makeInput(1000, 0, static_cast<size_t>(state.range(0)));
+	std::vector<std::pair<std::string_view, uint32_t>> infos;
+	std::vector<std::string_view> fields;
+	size_t bytes = 0;
+	for (auto line : input.dataLines) {
+		splitFields<'\t'>(line, fields);
+		infos.emplace_back(fields[7], countAltAlleles(fields[4]));
+		bytes += fields[7].size();
+	}
+	for (auto _ : state) {
+		for (auto [info, altAlleles] : infos) {
+			benchmark::DoNotOptimize(checkInfoField(info, input.header, altAlleles));
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * infos.size());
+	state.SetBytesProcessed(state.iterations() * bytes);
+}
+
+void BM_validateHeaderLine(benchmark::State &state)
+{
+	size_t bytes = 0;
+	for (auto _ : state) {
+		for (auto line : headerSamples) {
+			benchmark::DoNotOptimize(validateHeaderLine(line));
+			bytes += line.size();
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * std::size(headerSamples));
+	state.SetBytesProcessed(bytes);
+}
+
+// End to end over the data lines of a synthetic file: arguments are samples, INFO entries and worker threads
+// (0 validates on the calling thread); items are records
+void BM_validateBody(benchmark::State &state)
+{
+	auto const samples = static_cast<size_t>(state.range(0));
+	auto const infoFields = static_cast<size_t>(state.range(1));
+	auto const threads = static_cast<unsigned>(state.range(2));
+	SyntheticInput const input = makeInput(std::max<size_t>(200, 200000 / (samples + 1)), samples, infoFields);
+
+	std::ostringstream messages;
+	DiagnosticsRedirect redirect(messages);
+	std::optional<ThreadPool> pool;
+	if (threads != 0) {
+		pool.emplace(threads);
+	}
+	for (auto _ : state) {
+		bool valid = false;
+		if (pool) {
+			MemoryBlockReader reader(input.body, size_t{1} << 20);
+			ErrorCollector collector(1);
+			valid = validateBodyParallel(reader, *pool, collector, 1, &input.header);
+		} else {
+			RecordOrder order;
+			valid = forEachLine(input.body, [&input, &order](std::string_view line) {
+				return validateBodyLine(line, &input.header, &order);
+			});
+		}
+		if (!valid) {
+			state.SkipWithError("synthetic input failed validation");
+			break;
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * input.records);
+	state.SetBytesProcessed(state.iterations() * input.body.size());
+}
+
+// A whole synthetic file through one reused VcfValidator, fed in 64 KiB pieces like an upload; the argument is
+// samples per record
+void BM_vcfValidator(benchmark::State &state)
+{
+	auto const samples = static_cast<size_t>(state.range(0));
+	SyntheticInput const input = makeInput(std::max<size_t>(200, 200000 / (samples + 1)), samples, 4);
+	std::span<char const> const text(input.text);
+	size_t const pieceSize = size_t {64} << 10;
+
+	VcfValidator validator;
+	for (auto _ : state) {
+		validator.reset();
+		for (size_t offset = 0; offset < text.size(); offset += pieceSize) {
+			validator.feed(text.subspan(offset, std::min(pieceSize, text.size() - offset)));
+		}
+		if (!validator.finish()) {
+			state.SkipWithError("synthetic input failed validation");
+			break;
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * input.records);
+	state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+// One BGZF-sized block of synthetic records inflated by each built-in backend; the argument indexes
+// inflateBackends()
+void BM_inflateBlock(benchmark::State &state)
+{
+	auto const backends = inflateBackends();
+	auto const backend = static_cast<size_t>(state.range(0));
+	SyntheticInput const input = makeInput(2000, 10, 4);
+	std::string const text = input.text.substr(0, std::min<size_t>(input.text.size(), 65280));
+
+	// Raw deflate, as BGZF blocks carry it
+	std::vector<unsigned char> deflated(compressBound(static_cast<uLong>(text.size())));
+	z_stream stream {};
+	deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+	stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(text.data()));
+	stream.avail_in = static_cast<uInt>(text.size());
+	stream.next_out = deflated.data();
+	stream.avail_out = static_cast<uInt>(deflated.size());
+	deflate(&stream, Z_FINISH);
+	deflated.resize(stream.total_out);
+	deflateEnd(&stream);
+	auto const crc = static_cast<uint32_t>(
+		crc32(0, reinterpret_cast<Bytef const *>(text.data()), static_cast<uInt>(text.size())));
+
+	selectInflateBackend(backends[backend]);
+	state.SetLabel(std::string(backends[backend]));
+	std::vector<char> out(text.size());
+	for (auto _ : state) {
+		if (!threadInflater().inflate(deflated, out, crc)) {
+			state.SkipWithError("block failed to inflate");
+			break;
+		}
+		benchmark::DoNotOptimize(out.data());
+	}
+	selectInflateBackend(backends.front());
+	state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(text.size()));
+}
+
+} // namespace
+
+BENCHMARK(BM_altMatcher<isValidAlt>)->Name("isValidAlt/scanner");
+BENCHMARK(BM_altMatcher<isValidAltRegex>)->Name("isValidAlt/regex");
+BENCHMARK(BM_split)->Arg(10)->Arg(100)->Arg(1000);
+BENCHMARK(BM_splitFields)->Arg(10)->Arg(100)->Arg(1000);
+BENCHMARK(BM_isValidGenotype);
+BENCHMARK(BM_isValidBase)->Arg(1)->Arg(64)->Arg(4096);
+BENCHMARK(BM_isNonNegativeInteger);
+BENCHMARK(BM_checkFormatAndSamples)->Arg(1)->Arg(10)->Arg(100)->Arg(1000);
+BENCHMARK(BM_checkFormatAndSamplesSubset)->Arg(100)->Arg(1000);
+BENCHMARK(BM_checkFormatAndSamplesMultiAllelic)->ArgsProduct({{100, 1000}, {0, 1}});
+BENCHMARK(BM_checkDataLines)->Arg(1)->Arg(10)->Arg(100)->Arg(1000);
+BENCHMARK(BM_checkDataLinesProfile)->ArgsProduct({{100}, {0, 1, 2, 3}});
+BENCHMARK(BM_checkInfoField)->Arg(1)->Arg(4)->Arg(16);
+BENCHMARK(BM_validateHeaderLine);
+BENCHMARK(BM_validateBody)
+	->ArgNames({"samples", "info", "threads"})
+	->Args({0, 4, 0})
+	->Args({10, 4, 0})
+	->Args({10, 16, 0})
+	->Args({100, 4, 0})
+	->Args({1000, 4, 0})
+	->Args({100, 4, 2})
+	->UseRealTime()
+	->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_vcfValidator)->Arg(10)->Arg(100);
+BENCHMARK(BM_inflateBlock)->Apply([](benchmark::internal::Benchmark *benchmark) {
+	benchmark->DenseRange(0, static_cast<int>(inflateBackends().size()) - 1);
+});
+
+BENCHMARK_MAIN();
@@ -0,0 +1,179 @@
+#include "synthetic_vcf.hxx"
+
+#include <algorithm>
+#include <ostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+namespace {
+
+struct Contig {
+	std::string_view name;
+	uint32_t length;
+};
+
+// GRCh38 lengths
+constexpr Contig contigs[] = {
+	{"chr1", 248956422},
+	{"chr2", 242193529},
+	{"chr3", 198295559},
+	{"chr4", 190214555},
+	{"chr5", 181538259},
+	{"chr6", 170805979},
+	{"chr7", 159345973},
+	{"chr8", 145138636},
+	{"chr9", 138394717},
+	{"chr10", 133797422},
+	{"chr11", 135086622},
+	{"chr12", 133275309},
+	{"chr13", 114364328},
+	{"chr14", 107043718},
+	{"chr15", 101991189},
+	{"chr16", 90338345},
+	{"chr17", 83257441},
+	{"chr18", 80373285},
+	{"chr19", 58617616},
+	{"chr20", 64444167},
+	{"chr21", 46709983},
+	{"chr22", 50818468},
+	{"chrX", 156040895},
+};
+
+struct InfoKey {
+	std::string_view header;
+	std::string_view key;
+	enum class Kind
+	{
+		Integer,
+		Float,
+		Flag
+	} kind;
+	// Number=A: one value per ALT allele
+	bool perAltAllele = false;
+};
+
+constexpr InfoKey infoKeys[] = {
+	{"##INFO=<ID=DP,Number=1,Type=Integer,Description=\"Total Depth\">", "DP", InfoKey::Kind::Integer},
+	{"##INFO=<ID=AF,Number=A,Type=Float,Description=\"Allele Frequency\">", "AF", InfoKey::Kind::Float, true},
+	{"##INFO=<ID=AC,Number=A,Type=Integer,Description=\"Allele Count\">", "AC", InfoKey::Kind::Integer, true},
+	{"##INFO=<ID=AN,Number=1,Type=Integer,Description=\"Total number of alleles\">", "AN", InfoKey::Kind::Integer},
+	{"##INFO=<ID=MQ,Number=1,Type=Float,Description=\"RMS Mapping Quality\">", "MQ", InfoKey::Kind::Float},
+	{"##INFO=<ID=QD,Number=1,Type=Float,Description=\"Variant Confidence by Depth\">", "QD", InfoKey::Kind::Float},
+	{"##INFO=<ID=FS,Number=1,Type=Float,Description=\"Fisher Strand Bias\">", "FS", InfoKey::Kind::Float},
+	{"##INFO=<ID=SOR,Number=1,Type=Float,Description=\"Strand Odds Ratio\">", "SOR", InfoKey::Kind::Float},
+	{"##INFO=<ID=DB,Number=0,Type=Flag,Description=\"dbSNP Membership\">", "DB", InfoKey::Kind::Flag},
+	{"##INFO=<ID=END,Number=1,Type=Integer,Description=\"End position\">", "END", InfoKey::Kind::Integer},
+};
+
+constexpr std::string_view formatHeaders[] = {
+	"##FORMAT=<ID=GT,Number=1,Type=String,Description=\"Genotype\">",
+	"##FORMAT=<ID=DP,Number=1,Type=Integer,Description=\"Read Depth\">",
+	"##FORMAT=<ID=GQ,Number=1,Type=Integer,Description=\"Genotype Quality\">",
+	"##FORMAT=<ID=AD,Number=R,Type=Integer,Description=\"Allelic depths\">",
+};
+
+// Mostly SNVs, with indels, multi-allelics and a symbolic allele mixed in
+constexpr std::string_view altAlleles[] = {"A", "C", "G", "T", "A", "C", "G", "T", "AT", "A,T", "<DEL>", "*"};
+
+std::string_view const bases = "ACGT";
+
+void writeHeader(std::ostream &out, SyntheticVcfOptions const &options)
+{
+	out << "##fileformat=VCFv4.2\n";
+	for (auto const &contig : contigs) {
+		out << "##contig=<ID=" << contig.name << ",length=" << contig.length << ">\n";
+	}
+	for (auto const &info : infoKeys) {
+		out << info.header << '\n';
+	}
+	out << "##FILTER=<ID=q10,Description=\"Quality below 10\">\n";
+	for (auto header : formatHeaders) {
+		out << header << '\n';
+	}
+	out << "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT";
+	for (size_t i = 0; i < options.samples; ++i) {
+		out << "\tS" << i + 1;
+	}
+	out << '\n';
+}
+
+} // namespace
+
+void writeSyntheticVcf(std::ostream &out, SyntheticVcfOptions const &options)
+{
+	writeHeader(out, options);
+
+	std::mt19937_64 random(options.seed);
+	auto uniform = [&random](uint32_t bound) { return static_cast<uint32_t>(random() % bound); };
+
+	size_t const contigCount = std::size(contigs);
+	size_t const recordsPerContig = (options.records + contigCount - 1) / contigCount;
+	std::string line;
+	size_t written = 0;
+	for (size_t c = 0; c < contigCount && written < options.records; ++c) {
+		Contig const &contig = contigs[c];
+		// Spread the contig's records evenly, jittered inside their slot
+		uint32_t const slot = std::max<uint32_t>(1, static_cast<uint32_t>(contig.length / (recordsPerContig + 1)));
+		for (size_t r = 0; r < recordsPerContig && written < options.records; ++r, ++written) {
+			uint32_t const pos = static_cast<uint32_t>(r * slot) + 1 + uniform(slot);
+			std::string_view const alt = altAlleles[uniform(std::size(altAlleles))];
+			auto const altCount = static_cast<size_t>(std::ranges::count(alt, ',')) + 1;
+
+			line.clear();
+			line.append(contig.name).append("\t").append(std::to_string(pos));
+			line.append(uniform(4) == 0 ? "\trs" + std::to_string(random() % 100000000) : std::string("\t."));
+			line.append("\t").push_back(bases[uniform(4)]);
+			line.append("\t").append(alt);
+			line.append("\t").append(std::to_string(uniform(1000) / 10.0).substr(0, 5));
+			line.append(uniform(10) == 0 ? "\tq10\t" : "\tPASS\t");
+
+			if (options.infoFields == 0) {
+				line.push_back('.');
+			}
+			for (size_t i = 0; i < options.infoFields; ++i) {
+				InfoKey const &info = infoKeys[i % std::size(infoKeys)];
+				if (i != 0) {
+					line.push_back(';');
+				}
+				line.append(info.key);
+				size_t const values = info.kind == InfoKey::Kind::Flag ? 0 : info.perAltAllele ? altCount : 1;
+				for (size_t v = 0; v < values; ++v) {
+					line.append(v == 0 ? "=" : ",");
+					if (info.kind == InfoKey::Kind::Integer) {
+						line.append(std::to_string(uniform(5000)));
+					} else {
+						line.append("0.").append(std::to_string(uniform(1000)));
+					}
+				}
+			}
+
+			line.append("\tGT:DP:GQ:AD");
+			for (size_t s = 0; s < options.samples; ++s) {
+				uint32_t const depth = uniform(100);
+				uint32_t const refDepth = uniform(depth + 1);
+				line.push_back('\t');
+				line.push_back(static_cast<char>('0' + uniform(2)));
+				line.push_back(uniform(2) == 0 ? '/' : '|');
+				line.push_back(static_cast<char>('0' + uniform(2)));
+				line.append(":").append(std::to_string(depth));
+				line.append(":").append(std::to_string(uniform(100)));
+				// Number=R: the reads not supporting REF go to the first ALT allele
+				line.append(":").append(std::to_string(refDepth)).append(",").append(std::to_string(depth - refDepth));
+				for (size_t a = 1; a < altCount; ++a) {
+					line.append(",0");
+				}
+			}
+			line.push_back('\n');
+			out << line;
+		}
+	}
+}
+
+std::string makeSyntheticVcf(SyntheticVcfOptions const &options)
+{
+	std::ostringstream out;
+	writeSyntheticVcf(out, options);
+	return std::move(out).str();
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+// Shape of a generated VCF; the same options and seed always produce the same file
+struct SyntheticVcfOptions {
+	size_t records = 10000;
+	size_t samples = 10;
+	// INFO entries per record, 0 writes "."
+	size_t infoFields = 4;
+	uint64_t seed = 1;
+};
+
+// Writes a valid VCF with records spread over the human autosomes and chrX in position order.
+// Samples carry GT:DP:GQ:AD, the INFO keys are declared in the header.
+void writeSyntheticVcf(std::ostream &out, SyntheticVcfOptions const &options);
+std::string makeSyntheticVcf(SyntheticVcfOptions const &options);
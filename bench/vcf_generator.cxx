@@ -0,0 +1,151 @@
+#include "bgzf_writer.hxx"
+#include "synthetic_vcf.hxx"
+
+#include <charconv>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+namespace {
+
+void printUsage(char const *program)
+{
+	std::cerr << "Usage: " << program
+			  << " [--records N] [--samples N] [--info N] [--seed N] [--from FILE] [--compression none|gzip|bgzf]"
+			  << " <output file>\n"
+			  << "  --records N      data lines to write (default 10000)\n"
+			  << "  --samples N      sample columns per data line (default 10)\n"
+			  << "  --info N         INFO entries per data line, 0 writes '.' (default 4)\n"
+			  << "  --seed N         random seed, the same options and seed give the same file (default 1)\n"
+			  << "  --from FILE      write the text of FILE rather than synthetic records, to compress it\n"
+			  << "  --compression C  none, gzip or bgzf (default none)\n";
+}
+
+template<typename T>
+bool parseNumber(std::string_view text, T &value)
+{
+	auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+	return ec == std::errc() && ptr == text.data() + text.size();
+}
+
+enum class Compression
+{
+	None,
+	Gzip,
+	Bgzf
+};
+
+// The synthetic records, or the text of a file with --from
+void writeVcf(std::ostream &out, SyntheticVcfOptions const &options, std::ifstream *from)
+{
+	if (from) {
+		out << from->rdbuf();
+	} else {
+		writeSyntheticVcf(out, options);
+	}
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+	SyntheticVcfOptions options;
+	Compression compression = Compression::None;
+	std::string fileName;
+	std::string fromName;
+	for (int i = 1; i < argc; ++i) {
+		std::string_view const arg = argv[i];
+		bool ok = true;
+		if (arg == "--records" && i + 1 < argc) {
+			ok = parseNumber(argv[++i], options.records);
+		} else if (arg == "--samples" && i + 1 < argc) {
+			ok = parseNumber(argv[++i], options.samples);
+		} else if (arg == "--info" && i + 1 < argc) {
+			ok = parseNumber(argv[++i], options.infoFields);
+		} else if (arg == "--seed" && i + 1 < argc) {
+			ok = parseNumber(argv[++i], options.seed);
+		} else if (arg == "--from" && i + 1 < argc) {
+			fromName = argv[++i];
+		} else if (arg == "--compression" && i + 1 < argc) {
+			std::string_view const name = argv[++i];
+			if (name == "none") {
+				compression = Compression::None;
+			} else if (name == "gzip") {
+				compression = Compression::Gzip;
+			} else if (name == "bgzf") {
+				compression = Compression::Bgzf;
+			} else {
+				ok = false;
+			}
+		} else if (!arg.starts_with("--") && fileName.empty()) {
+			fileName = arg;
+		} else {
+			ok = false;
+		}
+		if (!ok) {
+			printUsage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (fileName.empty()) {
+		printUsage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	std::ifstream fromFile;
+	std::ifstream *from = nullptr;
+	if (!fromName.empty()) {
+		fromFile.open(fromName, std::ios_base::binary);
+		from = &fromFile;
+		if (!fromFile) {
+			std::cerr << "Failed to open file: " << fromName << '\n';
+			return EXIT_FAILURE;
+		}
+	}
+
+	std::ofstream file(fileName, std::ios_base::binary);
+	if (!file) {
+		std::cerr << "Failed to open file: " << fileName << '\n';
+		return EXIT_FAILURE;
+	}
+
+	try {
+		switch (compression) {
+		case Compression::None:
+			writeVcf(file, options, from);
+			break;
+		case Compression::Gzip: {
+			boost::iostreams::filtering_ostream out;
+			out.push(boost::iostreams::gzip_compressor());
+			out.push(file);
+			writeVcf(out, options, from);
+			break;
+		}
+		case Compression::Bgzf: {
+			BgzfWriter writer(file);
+			{
+				boost::iostreams::filtering_ostream out;
+				out.push(BgzfSink(writer));
+				writeVcf(out, options, from);
+			}
+			writer.finish();
+			break;
+		}
+		}
+	} catch (std::exception const &e) {
+		std::cerr << "Failed to write file: " << fileName << ": " << e.what() << '\n';
+		return EXIT_FAILURE;
+	}
+
+	if (!file.flush()) {
+		std::cerr << "Failed to write file: " << fileName << '\n';
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,324 @@
+#include "bgzf_reader.hxx"
+
+#include "decompressor.hxx"
+#include "thread_pool.hxx"
+#include "validation_stats.hxx"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <exception>
+#include <istream>
+#include <stdexcept>
+
+namespace {
+
+// Fixed part of a gzip member header: ID1 ID2 CM FLG MTIME(4) XFL OS XLEN(2)
+constexpr size_t gzipHeaderSize = 12;
+// CRC32 and ISIZE
+constexpr size_t gzipFooterSize = 8;
+// Blocks inflated by one task; 64 blocks of at most 64 KiB keep a batch around 4 MiB
+constexpr size_t blocksPerBatch = 64;
+
+uint16_t readLe16(unsigned char const *p)
+{
+	return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t readLe32(unsigned char const *p)
+{
+	return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16)
+		| (static_cast<uint32_t>(p[3]) << 24);
+}
+
+// Returns BSIZE + 1 (the total block size) from the extra field, or 0 if there is no BC subfield
+size_t blockSizeFromExtra(unsigned char const *extra, size_t extraSize)
+{
+	size_t offset = 0;
+	while (offset + 4 <= extraSize) {
+		uint16_t const subfieldSize = readLe16(extra + offset + 2);
+		if (extra[offset] == 'B' && extra[offset + 1] == 'C' && subfieldSize == 2 && offset + 6 <= extraSize) {
+			return static_cast<size_t>(readLe16(extra + offset + 4)) + 1;
+		}
+		offset += 4 + subfieldSize;
+	}
+	return 0;
+}
+
+bool isGzipMemberHeader(unsigned char const *header)
+{
+	// FEXTRA must be set, BGZF stores the block size there
+	return header[0] == 0x1f && header[1] == 0x8b && header[2] == 8 && (header[3] & 4) != 0;
+}
+
+// Appends the next whole block of compressed to out, returns false at the end of the input.
+// Throws std::runtime_error on a malformed or truncated block.
+bool readBlock(std::istream &compressed, std::vector<unsigned char> &out)
+{
+	std::array<unsigned char, gzipHeaderSize> header {};
+	compressed.read(reinterpret_cast<char *>(header.data()), header.size());
+	if (compressed.gcount() == 0) {
+		return false;
+	}
+	if (compressed.gcount() != static_cast<std::streamsize>(header.size()) || !isGzipMemberHeader(header.data())) {
+		throw std::runtime_error("Malformed BGZF block header");
+	}
+
+	size_t const extraSize = readLe16(header.data() + 10);
+	size_t const offset = out.size();
+	out.resize(offset + gzipHeaderSize + extraSize);
+	std::memcpy(out.data() + offset, header.data(), header.size());
+	unsigned char *extra = out.data() + offset + gzipHeaderSize;
+	compressed.read(reinterpret_cast<char *>(extra), static_cast<std::streamsize>(extraSize));
+	size_t const blockSize = blockSizeFromExtra(extra, extraSize);
+	if (compressed.gcount() != static_cast<std::streamsize>(extraSize) || blockSize == 0
+		|| blockSize < gzipHeaderSize + extraSize + gzipFooterSize) {
+		throw std::runtime_error("Malformed BGZF block header");
+	}
+
+	size_t const headerSize = gzipHeaderSize + extraSize;
+	out.resize(offset + blockSize);
+	compressed.read(reinterpret_cast<char *>(out.data() + offset + headerSize),
+		static_cast<std::streamsize>(blockSize - headerSize));
+	if (compressed.gcount() != static_cast<std::streamsize>(blockSize - headerSize)) {
+		throw std::runtime_error("Truncated BGZF block");
+	}
+	return true;
+}
+
+// Size of the block's data once inflated, from the ISIZE footer field
+size_t inflatedBlockSize(unsigned char const *block, size_t blockSize)
+{
+	return readLe32(block + blockSize - 4);
+}
+
+// Inflates one whole block into out, which has room for inflatedBlockSize(); false if it is corrupt
+bool inflateBlock(unsigned char const *block, size_t blockSize, char *out)
+{
+	size_t const headerSize = gzipHeaderSize + readLe16(block + 10);
+	unsigned char const *footer = block + blockSize - gzipFooterSize;
+	uint32_t const expectedCrc = readLe32(footer);
+	uint32_t const inflatedSize = readLe32(footer + 4);
+	return threadInflater().inflate(
+		{block + headerSize, blockSize - headerSize - gzipFooterSize}, {out, inflatedSize}, expectedCrc);
+}
+
+} // namespace
+
+struct BgzfReader::Batch {
+	std::vector<unsigned char> compressed;
+	// Start of every block inside compressed, plus the end of the last one
+	std::vector<size_t> blockOffsets;
+	std::vector<char> inflated;
+	// What reading the blocks after the last one in the batch threw
+	std::exception_ptr readError;
+	std::promise<void> ready;
+	std::shared_future<void> done = ready.get_future().share();
+
+	void inflateBlocks();
+};
+
+void BgzfReader::Batch::inflateBlocks()
+{
+	ScopedStageTimer timer(StatsStage::Decompress);
+	size_t outOffset = 0;
+	bool ok = true;
+	for (size_t i = 0; ok && i + 1 < blockOffsets.size(); ++i) {
+		unsigned char *block = compressed.data() + blockOffsets[i];
+		size_t const blockSize = blockOffsets[i + 1] - blockOffsets[i];
+		ok = inflateBlock(block, blockSize, inflated.data() + outOffset);
+		outOffset += inflatedBlockSize(block, blockSize);
+	}
+
+	if (!ok) {
+		throw std::runtime_error("Corrupt BGZF block");
+	}
+}
+
+bool isBgzf(std::istream &compressed)
+{
+	std::array<unsigned char, 18> header {};
+	auto const start = compressed.tellg();
+	compressed.read(reinterpret_cast<char *>(header.data()), header.size());
+	bool const complete = compressed.gcount() == static_cast<std::streamsize>(header.size());
+	compressed.clear();
+	compressed.seekg(start);
+
+	return complete && isGzipMemberHeader(header.data())
+		&& blockSizeFromExtra(header.data() + gzipHeaderSize,
+			   std::min<size_t>(readLe16(header.data() + 10), header.size() - gzipHeaderSize))
+		!= 0;
+}
+
+BgzfReader::BgzfReader(std::istream &compressed, ThreadPool *pool)
+	: compressed(compressed)
+	, pool(pool)
+	, lookahead(pool != nullptr ? pool->size() * 2 : 1)
+{
+}
+
+BgzfReader::~BgzfReader()
+{
+	// Inflate tasks still reference their batch, wait for them before the batches go away
+	for (auto &batch : pending) {
+		batch->done.wait();
+	}
+}
+
+bool BgzfReader::scheduleBatch()
+{
+	auto batch = std::make_shared<Batch>();
+	size_t inflatedSize = 0;
+
+	try {
+		while (batch->blockOffsets.size() < blocksPerBatch) {
+			size_t const offset = batch->compressed.size();
+			if (!readBlock(compressed, batch->compressed)) {
+				inputExhausted = true;
+				break;
+			}
+			batch->blockOffsets.push_back(offset);
+			inflatedSize += inflatedBlockSize(batch->compressed.data() + offset, batch->compressed.size() - offset);
+		}
+	} catch (...) {
+		// Kept in the batch, so that every read from here on throws it rather than reading past the bad block
+		batch->readError = std::current_exception();
+		inputExhausted = true;
+	}
+
+	if (batch->blockOffsets.empty() && !batch->readError) {
+		return false;
+	}
+	batch->blockOffsets.push_back(batch->compressed.size());
+	batch->inflated.resize(inflatedSize);
+
+	auto inflateTask = [batch] {
+		try {
+			batch->inflateBlocks();
+			if (batch->readError) {
+				std::rethrow_exception(batch->readError);
+			}
+			batch->ready.set_value();
+		} catch (...) {
+			batch->ready.set_exception(std::current_exception());
+		}
+	};
+	pending.push_back(batch);
+	if (pool != nullptr) {
+		pool->submit(inflateTask);
+	} else {
+		inflateTask();
+	}
+	return true;
+}
+
+size_t BgzfReader::read(char *buffer, size_t size)
+{
+	size_t copied = 0;
+	while (copied < size) {
+		while (!inputExhausted && pending.size() < lookahead) {
+			if (!scheduleBatch()) {
+				break;
+			}
+		}
+		if (pending.empty()) {
+			break;
+		}
+
+		auto &batch = *pending.front();
+		batch.done.get(); // Rethrows inflate errors
+		size_t const count = std::min(size - copied, batch.inflated.size() - consumed);
+		std::memcpy(buffer + copied, batch.inflated.data() + consumed, count);
+		copied += count;
+		consumed += count;
+		if (consumed == batch.inflated.size()) {
+			pending.pop_front();
+			consumed = 0;
+		}
+	}
+	return copied;
+}
+
+BgzfCursor::BgzfCursor(std::istream &compressed)
+	: compressed(compressed)
+{
+}
+
+void BgzfCursor::seek(uint64_t virtualOffset)
+{
+	uint64_t const target = virtualOffset >> 16;
+	atEnd = false;
+	if ((!loaded || target != blockOffset) && !loadBlock(target)) {
+		// No block there: the end of the input, which later reads stay at
+		atEnd = true;
+		blockOffset = target;
+		position = 0;
+		return;
+	}
+	position = std::min<size_t>(virtualOffset & 0xffff, data.size());
+}
+
+uint64_t BgzfCursor::tell() const
+{
+	// The end of a block is the start of the next one
+	if (loaded && position == data.size()) {
+		return nextBlockOffset << 16;
+	}
+	return (blockOffset << 16) | position;
+}
+
+bool BgzfCursor::readLine(std::string &line)
+{
+	line.clear();
+	if (atEnd) {
+		return false;
+	}
+	bool found = false;
+	while (true) {
+		if (!loaded || position == data.size()) {
+			// Empty blocks, like the end-of-file marker, carry no data; skip them
+			do {
+				// Before the first seek() reading starts with the block at offset 0
+				uint64_t const offset = loaded ? nextBlockOffset : blockOffset;
+				if (!loadBlock(offset)) {
+					// Past the last block; tell() stays there and every later call returns false
+					atEnd = true;
+					blockOffset = offset;
+					position = 0;
+					return found;
+				}
+			} while (data.empty());
+		}
+		std::string_view const rest(data.data() + position, data.size() - position);
+		auto const newline = rest.find('\n');
+		line.append(rest.substr(0, newline));
+		found = true;
+		if (newline != std::string_view::npos) {
+			position += newline + 1;
+			return true;
+		}
+		position = data.size();
+	}
+}
+
+bool BgzfCursor::loadBlock(uint64_t offset)
+{
+	ScopedStageTimer timer(StatsStage::Decompress);
+	compressed.clear();
+	compressed.seekg(static_cast<std::streamoff>(offset));
+	raw.clear();
+	if (!compressed || !readBlock(compressed, raw)) {
+		loaded = false;
+		data.clear();
+		return false;
+	}
+	data.resize(inflatedBlockSize(raw.data(), raw.size()));
+	if (!inflateBlock(raw.data(), raw.size(), data.data())) {
+		throw std::runtime_error("Corrupt BGZF block");
+	}
+	loaded = true;
+	blockOffset = offset;
+	nextBlockOffset = offset + raw.size();
+	position = 0;
+	return true;
+}
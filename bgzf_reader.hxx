@@ -0,0 +1,76 @@
+#pragma once
+
+#include "decompressor.hxx"
+
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+// True if the stream starts with a BGZF block (a gzip member carrying the "BC" extra subfield).
+// The stream is rewound to where it was.
+bool isBgzf(std::istream &compressed);
+
+// Decompresses BGZF input in batches of blocks, inflating several batches ahead on a thread pool
+class BgzfReader final : public Decompressor {
+public:
+	// Without a pool every batch is inflated on the reading thread
+	BgzfReader(std::istream &compressed, ThreadPool *pool);
+	~BgzfReader() override;
+
+	BgzfReader(BgzfReader const &) = delete;
+	BgzfReader &operator=(BgzfReader const &) = delete;
+
+	// Copies up to size decompressed bytes in input order, returns 0 at the end of the input.
+	// Throws std::runtime_error on malformed or corrupt blocks.
+	size_t read(char *buffer, size_t size) override;
+
+private:
+	struct Batch;
+
+	// Reads the next batch of compressed blocks and schedules its inflation, false at end of input
+	bool scheduleBatch();
+
+	std::istream &compressed;
+	ThreadPool *pool;
+	size_t lookahead;
+	std::deque<std::shared_ptr<Batch>> pending;
+	size_t consumed = 0; // Bytes of pending.front() already handed out
+	bool inputExhausted = false;
+};
+
+// Reads lines from any virtual offset (compressed block offset << 16 | offset inside the inflated block) of a BGZF
+// file, inflating one block at a time; used to jump to the chunks a tabix or CSI index points at
+class BgzfCursor {
+public:
+	explicit BgzfCursor(std::istream &compressed);
+
+	BgzfCursor(BgzfCursor const &) = delete;
+	BgzfCursor &operator=(BgzfCursor const &) = delete;
+
+	void seek(uint64_t virtualOffset);
+	// Virtual offset of the next unread byte
+	uint64_t tell() const;
+	// Reads the next line without its newline, false at the end of the input and on every call after it until the
+	// next seek().
+	// Throws std::runtime_error on malformed or corrupt blocks.
+	bool readLine(std::string &line);
+
+private:
+	bool loadBlock(uint64_t offset);
+
+	std::istream &compressed;
+	std::vector<unsigned char> raw;
+	std::vector<char> data;
+	uint64_t blockOffset = 0;
+	uint64_t nextBlockOffset = 0;
+	size_t position = 0;
+	bool loaded = false;
+	// Set once a read or seek finds no block, cleared by the next seek()
+	bool atEnd = false;
+};
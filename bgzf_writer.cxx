@@ -0,0 +1,142 @@
+#include "bgzf_writer.hxx"
+
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+
+#include <zlib.h>
+
+namespace {
+
+// gzip header with the BC extra subfield, footer with CRC32 and ISIZE
+constexpr size_t blockHeaderSize = 18;
+constexpr size_t blockFooterSize = 8;
+constexpr size_t maxBlockSize = 0x10000;
+
+void putLe16(char *p, uint32_t value)
+{
+	p[0] = static_cast<char>(value & 0xff);
+	p[1] = static_cast<char>((value >> 8) & 0xff);
+}
+
+void putLe32(char *p, uint32_t value)
+{
+	putLe16(p, value & 0xffff);
+	putLe16(p + 2, value >> 16);
+}
+
+} // namespace
+
+void deflateBgzfBlock(std::span<std::string_view const> pieces, int level, std::string &out)
+{
+	out.resize(maxBlockSize);
+	char *block = out.data();
+
+	z_stream stream {};
+	if (deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+		throw std::runtime_error("Failed to initialize zlib");
+	}
+	stream.next_out = reinterpret_cast<Bytef *>(block + blockHeaderSize);
+	stream.avail_out = static_cast<uInt>(maxBlockSize - blockHeaderSize - blockFooterSize);
+	uLong crc = crc32(0L, Z_NULL, 0);
+	size_t inputSize = 0;
+	int status = pieces.empty() ? deflate(&stream, Z_FINISH) : Z_OK;
+	for (size_t i = 0; i < pieces.size(); ++i) {
+		std::string_view const piece = pieces[i];
+		bool const last = i + 1 == pieces.size();
+		if (piece.empty() && !last) {
+			continue;
+		}
+		auto const *bytes = reinterpret_cast<Bytef const *>(piece.data());
+		stream.next_in = const_cast<Bytef *>(bytes);
+		stream.avail_in = static_cast<uInt>(piece.size());
+		status = deflate(&stream, last ? Z_FINISH : Z_NO_FLUSH);
+		crc = crc32(crc, bytes, static_cast<uInt>(piece.size()));
+		inputSize += piece.size();
+		if (status != Z_OK && status != Z_STREAM_END) {
+			break;
+		}
+	}
+	size_t const deflatedSize = stream.total_out;
+	deflateEnd(&stream);
+	if (status != Z_STREAM_END || inputSize > bgzfBlockInputSize) {
+		throw std::runtime_error("BGZF block does not fit after compression");
+	}
+
+	size_t const blockSize = blockHeaderSize + deflatedSize + blockFooterSize;
+	char const header[blockHeaderSize] = {
+		'\x1f', '\x8b', 8, 4, 0, 0, 0, 0, 0, '\xff', 6, 0, 'B', 'C', 2, 0, 0, 0};
+	std::copy(header, header + blockHeaderSize, block);
+	putLe16(block + 16, static_cast<uint32_t>(blockSize - 1));
+
+	char *footer = block + blockHeaderSize + deflatedSize;
+	putLe32(footer, static_cast<uint32_t>(crc));
+	putLe32(footer + 4, static_cast<uint32_t>(inputSize));
+	out.resize(blockSize);
+}
+
+BgzfWriter::BgzfWriter(std::ostream &out, int level)
+	: out(out)
+	, level(level)
+{
+	pending.reserve(bgzfBlockInputSize);
+}
+
+BgzfWriter::~BgzfWriter()
+{
+	if (!finished) {
+		try {
+			finish();
+		} catch (std::exception const &) {
+			// Destructors must not throw; a caller that cares calls finish() itself
+		}
+	}
+}
+
+void BgzfWriter::write(std::string_view data)
+{
+	while (!data.empty()) {
+		size_t const room = bgzfBlockInputSize - pending.size();
+		if (pending.empty() && data.size() >= bgzfBlockInputSize) {
+			writeBlock(data.substr(0, bgzfBlockInputSize));
+			data.remove_prefix(bgzfBlockInputSize);
+			continue;
+		}
+		size_t const take = std::min(room, data.size());
+		pending.append(data.substr(0, take));
+		data.remove_prefix(take);
+		if (pending.size() == bgzfBlockInputSize) {
+			writeBlock(pending);
+			pending.clear();
+		}
+	}
+}
+
+void BgzfWriter::finish()
+{
+	if (finished) {
+		return;
+	}
+	finished = true;
+	if (!pending.empty()) {
+		writeBlock(pending);
+		pending.clear();
+	}
+	writeBlock({});
+	out.flush();
+}
+
+void BgzfWriter::writeBlock(std::string_view data)
+{
+	deflateBgzfBlock(data.empty() ? std::span<std::string_view const>() : std::span(&data, 1), level, compressed);
+	if (!out.write(compressed.data(), static_cast<std::streamsize>(compressed.size()))) {
+		throw std::runtime_error("Failed to write BGZF block");
+	}
+}
+
+std::streamsize BgzfSink::write(char const *data, std::streamsize size)
+{
+	writer->write(std::string_view(data, static_cast<size_t>(size)));
+	return size;
+}
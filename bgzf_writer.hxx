@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include <boost/iostreams/categories.hpp>
+
+// Uncompressed bytes per block, the figure bgzip uses so that even incompressible data fits BSIZE
+constexpr size_t bgzfBlockInputSize = 0xff00;
+
+// Compresses the concatenation of pieces, at most bgzfBlockInputSize bytes in all, into one BGZF block in out,
+// reading the pieces where they are. No pieces give the empty end-of-file block. Throws std::runtime_error if
+// compression fails.
+void deflateBgzfBlock(std::span<std::string_view const> pieces, int level, std::string &out);
+
+// Writes BGZF (blocked gzip, readable by bgzip, tabix and BgzfReader) to a stream
+class BgzfWriter {
+public:
+	explicit BgzfWriter(std::ostream &out, int level = 6);
+	// Calls finish() if it has not been called yet
+	~BgzfWriter();
+
+	BgzfWriter(BgzfWriter const &) = delete;
+	BgzfWriter &operator=(BgzfWriter const &) = delete;
+
+	// Throws std::runtime_error if compression fails
+	void write(std::string_view data);
+	// Flushes the last block and appends the empty end-of-file block
+	void finish();
+
+private:
+	void writeBlock(std::string_view data);
+
+	std::ostream &out;
+	int level;
+	std::string pending; // Input not yet compressed, always less than one block
+	std::string compressed;
+	bool finished = false;
+};
+
+// Adapts a BgzfWriter to a boost::iostreams sink so it can sit at the end of a filtering_ostream
+class BgzfSink {
+public:
+	using char_type = char;
+	using category = boost::iostreams::sink_tag;
+
+	explicit BgzfSink(BgzfWriter &writer)
+		: writer(&writer)
+	{
+	}
+
+	std::streamsize write(char const *data, std::streamsize size);
+
+private:
+	BgzfWriter *writer;
+};
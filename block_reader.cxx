@@ -0,0 +1,95 @@
+#include "block_reader.hxx"
+
+#include "validation_stats.hxx"
+
+#include <algorithm>
+#include <cstring>
+#include <istream>
+
+StreamBlockReader::StreamBlockReader(std::istream &in, size_t blockSize)
+	: in(in)
+	, blockSize(blockSize)
+{
+}
+
+bool StreamBlockReader::next(TextBlock &block)
+{
+	ScopedStageTimer timer(StatsStage::Read);
+	if (exhausted && carry.empty()) {
+		return false;
+	}
+
+	size_t capacity = std::max(blockSize, carry.size() * 2);
+	std::unique_ptr<char[]> storage;
+	if (block.storage != nullptr && block.capacity >= capacity) {
+		storage = std::move(block.storage);
+		capacity = block.capacity;
+	} else {
+		storage = std::make_unique_for_overwrite<char[]>(capacity);
+	}
+	std::memcpy(storage.get(), carry.data(), carry.size());
+	size_t size = carry.size();
+	carry.clear();
+
+	while (!exhausted) {
+		in.read(storage.get() + size, static_cast<std::streamsize>(capacity - size));
+		size += static_cast<size_t>(in.gcount());
+		if (!in) {
+			exhausted = true; // Whatever was read is the final block
+			break;
+		}
+
+		// Cut after the last complete line and carry the rest over to the next block
+		auto const last = std::string_view(storage.get(), size).rfind('\n');
+		if (last != std::string_view::npos) {
+			carry.assign(storage.get() + last + 1, size - last - 1);
+			size = last + 1;
+			break;
+		}
+
+		// A single line longer than the block, grow and keep reading
+		auto grown = std::make_unique_for_overwrite<char[]>(capacity * 2);
+		std::memcpy(grown.get(), storage.get(), size);
+		storage = std::move(grown);
+		capacity *= 2;
+	}
+
+	if (size == 0) {
+		return false;
+	}
+
+	block.storage = std::move(storage);
+	block.capacity = capacity;
+	block.text = std::string_view(block.storage.get(), size);
+	countStats(StatsCounter::Bytes, size);
+	return true;
+}
+
+MemoryBlockReader::MemoryBlockReader(std::string_view data, size_t blockSize)
+	: remaining(data)
+	, blockSize(std::max<size_t>(blockSize, 1))
+{
+}
+
+bool MemoryBlockReader::next(TextBlock &block)
+{
+	if (remaining.empty()) {
+		return false;
+	}
+
+	// Extend the block to the end of the line crossing its nominal size
+	size_t size = remaining.size();
+	if (blockSize < remaining.size()) {
+		auto const newline = remaining.find('\n', blockSize - 1);
+		if (newline != std::string_view::npos) {
+			size = newline + 1;
+		}
+	}
+
+	block.storage.reset();
+	block.capacity = 0;
+	block.text = remaining.substr(0, size);
+	countStats(StatsCounter::Bytes, size);
+	remaining.remove_prefix(size);
+	return true;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "delimiter_scan.hxx"
+
+#include <cstddef>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// A run of whole lines taken from the decompressed input
+struct TextBlock {
+	// Null when text points into memory that outlives the block, such as a file mapping
+	std::unique_ptr<char[]> storage;
+	// Bytes allocated for storage, readers filling a block again reuse it when it is large enough
+	size_t capacity = 0;
+	// Only the last block of the input may end without a newline
+	std::string_view text;
+};
+
+// Calls visit(line) for every line of text, splitting exactly like std::getline; stops early when visit returns false
+template<typename Visitor>
+bool forEachLine(std::string_view text, Visitor &&visit)
+{
+	if (text.empty()) {
+		return true;
+	}
+	// A final newline terminates the last line instead of starting an empty one
+	if (text.back() == '\n') {
+		text.remove_suffix(1);
+	}
+	return forEachField<'\n'>(text, visit);
+}
+
+// Cuts decompressed input into newline-aligned blocks
+class BlockReader {
+public:
+	virtual ~BlockReader() = default;
+
+	// Fills block with the next run of whole lines, returns false at the end of the input
+	virtual bool next(TextBlock &block) = 0;
+};
+
+class StreamBlockReader final : public BlockReader {
+public:
+	StreamBlockReader(std::istream &in, size_t blockSize);
+
+	bool next(TextBlock &block) override;
+
+private:
+	std::istream &in;
+	size_t blockSize;
+	// Start of a line that did not fit into the previous block
+	std::string carry;
+	bool exhausted = false;
+};
+
+// Cuts an in-memory buffer into blocks that point straight into it, without copying
+class MemoryBlockReader final : public BlockReader {
+public:
+	MemoryBlockReader(std::string_view data, size_t blockSize);
+
+	bool next(TextBlock &block) override;
+
+private:
+	std::string_view remaining;
+	size_t blockSize;
+};
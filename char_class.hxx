@@ -0,0 +1,64 @@
+#pragma once
+
+#include "delimiter_scan.hxx"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Fixed character sets for the field scanners. Every set has a 256-entry table built at compile time, so a member test
+// is one load instead of a switch, and a SIMD kernel (the delimiter_scan.hxx masks) for testing long runs such as
+// the multi-kb REF alleles of structural variants 64 bytes at a time.
+template<char... Members>
+struct CharSet {
+	static constexpr std::array<bool, 256> table = [] {
+		std::array<bool, 256> members {};
+		((members[static_cast<unsigned char>(Members)] = true), ...);
+		return members;
+	}();
+
+	static constexpr bool contains(char c)
+	{
+		return table[static_cast<unsigned char>(c)];
+	}
+
+	// Length of the run of members text starts with
+	static size_t span(std::string_view text)
+	{
+		size_t offset = 0;
+		for (; offset + 64 <= text.size(); offset += 64) {
+			uint64_t const mask = simd::delimiterMask64<Members...>(text.data() + offset);
+			if (mask != ~uint64_t(0)) {
+				return offset + static_cast<size_t>(std::countr_one(mask));
+			}
+		}
+		while (offset < text.size() && contains(text[offset])) {
+			++offset;
+		}
+		return offset;
+	}
+
+	static bool all(std::string_view text)
+	{
+		// Most fields are only a few characters, too short for the SIMD kernel to pay off
+		if (text.size() < 64) {
+			bool members = true;
+			for (char c : text) {
+				members &= contains(c);
+			}
+			return members;
+		}
+		return span(text) == text.size();
+	}
+};
+
+namespace char_class {
+using Digits = CharSet<'0', '1', '2', '3', '4', '5', '6', '7', '8', '9'>;
+// REF bases in either case
+using Bases = CharSet<'A', 'C', 'G', 'T', 'N', 'a', 'c', 'g', 't', 'n'>;
+// Bases of a non-symbolic ALT allele, where '*' stands for an allele missing because of an upstream deletion
+using AltBases = CharSet<'A', 'C', 'G', 'T', 'N', '*'>;
+using GenotypeSeparators = CharSet<'/', '|'>;
+} // namespace char_class
@@ -0,0 +1,95 @@
+#include "checkpoint.hxx"
+
+#include "vcf_validation.hxx"
+
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <sstream>
+#include <system_error>
+
+// The sidecar is a few lines of text:
+//   vcfcheck 1
+//   header <hash>
+//   checks <profile and sample selection, to the end of the line>
+//   line <number> <offset> <hash>
+//   run <first line> <first POS> <last POS> <contig, to the end of the line>    (one per ContigRun)
+// A contig name is whatever CHROM holds, spaces included, but never a newline, so it ends its line like the checks.
+namespace {
+
+constexpr std::string_view magic = "vcfcheck 1";
+
+} // namespace
+
+bool readCheckpoint(std::string const &fileName, Checkpoint &checkpoint)
+{
+	std::ifstream in(checkpointFileName(fileName));
+	std::string line;
+	if (!in.is_open() || !std::getline(in, line) || line != magic) {
+		return false;
+	}
+
+	Checkpoint read;
+	bool haveHeader = false;
+	bool haveLine = false;
+	while (std::getline(in, line)) {
+		std::istringstream fields(line);
+		std::string key;
+		fields >> key;
+		if (key == "header") {
+			fields >> std::hex >> read.headerHash;
+			haveHeader = true;
+		} else if (key == "checks") {
+			fields.get();
+			std::getline(fields, read.checks);
+		} else if (key == "line") {
+			fields >> read.line >> read.lineOffset >> std::hex >> read.lineHash;
+			haveLine = true;
+		} else if (key == "run") {
+			ContigRun run;
+			fields >> run.firstLine >> run.firstPos >> run.lastPos;
+			fields.get();
+			std::getline(fields, run.contig);
+			read.runs.push_back(std::move(run));
+		} else {
+			return false;
+		}
+		if (fields.fail()) {
+			return false;
+		}
+	}
+	if (!haveHeader || !haveLine) {
+		return false;
+	}
+	checkpoint = std::move(read);
+	return true;
+}
+
+bool writeCheckpoint(std::string const &fileName, Checkpoint const &checkpoint)
+{
+	std::string const path = checkpointFileName(fileName);
+	std::string const temporary = path + ".tmp";
+	{
+		std::ofstream out(temporary, std::ios_base::out | std::ios_base::trunc);
+		out << magic << '\n'
+			<< "header " << std::hex << checkpoint.headerHash << std::dec << '\n'
+			<< "checks " << checkpoint.checks << '\n'
+			<< "line " << checkpoint.line << ' ' << checkpoint.lineOffset << ' ' << std::hex << checkpoint.lineHash
+			<< std::dec << '\n';
+		for (auto const &run : checkpoint.runs) {
+			out << "run " << run.firstLine << ' ' << run.firstPos << ' ' << run.lastPos << ' ' << run.contig << '\n';
+		}
+		if (!out.flush()) {
+			diagnostics() << "Failed to write file: " << temporary << '\n';
+			return false;
+		}
+	}
+	std::error_code error;
+	std::filesystem::rename(temporary, path, error);
+	if (error) {
+		diagnostics() << "Failed to write file: " << path << ": " << error.message() << '\n';
+		std::filesystem::remove(temporary, error);
+		return false;
+	}
+	return true;
+}
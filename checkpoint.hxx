@@ -0,0 +1,47 @@
+#pragma once
+
+#include "record_order.hxx"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Where validation of a file got to with every line before it valid, kept next to the file as <file>.vcfcheck so
+// that a rerun continues from there instead of from the first byte (--checkpoint, --resume). Offsets are BGZF
+// virtual offsets for compressed files and byte offsets for uncompressed ones.
+struct Checkpoint {
+	// checkpointHash of the header section, every line up to and including the column header line
+	uint64_t headerHash = 0;
+	// The checks the lines were validated with: the --profile and the sample selection
+	std::string checks;
+	// Number of the last validated line, its offset and checkpointHash. Resuming reads that line again and only
+	// continues if it is unchanged, so a file that was rewritten rather than appended to is validated from the start.
+	uint64_t line = 0;
+	uint64_t lineOffset = 0;
+	uint64_t lineHash = 0;
+	// RecordOrder state after that line, so records appended later are checked against the ones before them
+	std::vector<ContigRun> runs;
+};
+
+// FNV-1a of text continuing from hash; start with checkpointHashSeed
+constexpr uint64_t checkpointHashSeed = 0xcbf29ce484222325;
+constexpr uint64_t checkpointHash(uint64_t hash, std::string_view text)
+{
+	for (char const c : text) {
+		hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3;
+	}
+	return hash;
+}
+
+inline std::string checkpointFileName(std::string const &fileName)
+{
+	return fileName + ".vcfcheck";
+}
+
+// Reads the checkpoint of fileName, false if there is none or it is malformed
+bool readCheckpoint(std::string const &fileName, Checkpoint &checkpoint);
+
+// Replaces the checkpoint of fileName; written to a temporary file and renamed over the old one, so a run killed
+// while writing leaves the previous checkpoint intact. False, with a message on diagnostics(), if it fails.
+bool writeCheckpoint(std::string const &fileName, Checkpoint const &checkpoint);
@@ -0,0 +1,156 @@
+#include "content_hash.hxx"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <ios>
+#include <memory>
+
+namespace {
+
+constexpr uint64_t prime1 = 11400714785074694791ULL;
+constexpr uint64_t prime2 = 14029467366897019727ULL;
+constexpr uint64_t prime3 = 1609587929392839161ULL;
+constexpr uint64_t prime4 = 9650029242287828579ULL;
+constexpr uint64_t prime5 = 2870177450012600261ULL;
+
+uint64_t load64(char const *data)
+{
+	uint64_t value = 0;
+	std::memcpy(&value, data, sizeof(value));
+	return std::endian::native == std::endian::little ? value : std::byteswap(value);
+}
+
+uint32_t load32(char const *data)
+{
+	uint32_t value = 0;
+	std::memcpy(&value, data, sizeof(value));
+	return std::endian::native == std::endian::little ? value : std::byteswap(value);
+}
+
+uint64_t round(uint64_t lane, uint64_t input)
+{
+	return std::rotl(lane + input * prime2, 31) * prime1;
+}
+
+uint64_t mergeRound(uint64_t hash, uint64_t lane)
+{
+	return (hash ^ round(0, lane)) * prime1 + prime4;
+}
+
+void consumeStripe(std::array<uint64_t, 4> &lanes, char const *stripe)
+{
+	for (size_t i = 0; i < lanes.size(); ++i) {
+		lanes[i] = round(lanes[i], load64(stripe + i * 8));
+	}
+}
+
+} // namespace
+
+Xxh64::Xxh64(uint64_t seed)
+	: lanes {seed + prime1 + prime2, seed + prime2, seed, seed - prime1}
+	, seed(seed)
+{
+}
+
+void Xxh64::update(std::string_view data)
+{
+	totalSize += data.size();
+	if (pendingSize != 0) {
+		size_t const taken = std::min(data.size(), pending.size() - pendingSize);
+		std::memcpy(pending.data() + pendingSize, data.data(), taken);
+		pendingSize += taken;
+		data.remove_prefix(taken);
+		if (pendingSize < pending.size()) {
+			return;
+		}
+		consumeStripe(lanes, pending.data());
+		pendingSize = 0;
+	}
+	while (data.size() >= pending.size()) {
+		consumeStripe(lanes, data.data());
+		data.remove_prefix(pending.size());
+	}
+	std::memcpy(pending.data(), data.data(), data.size());
+	pendingSize = data.size();
+}
+
+uint64_t Xxh64::digest() const
+{
+	uint64_t hash = 0;
+	if (totalSize >= pending.size()) {
+		hash = std::rotl(lanes[0], 1) + std::rotl(lanes[1], 7) + std::rotl(lanes[2], 12) + std::rotl(lanes[3], 18);
+		for (uint64_t const lane : lanes) {
+			hash = mergeRound(hash, lane);
+		}
+	} else {
+		hash = seed + prime5;
+	}
+	hash += totalSize;
+
+	char const *rest = pending.data();
+	size_t size = pendingSize;
+	for (; size >= 8; rest += 8, size -= 8) {
+		hash = std::rotl(hash ^ round(0, load64(rest)), 27) * prime1 + prime4;
+	}
+	if (size >= 4) {
+		hash = std::rotl(hash ^ (uint64_t {load32(rest)} * prime1), 23) * prime2 + prime3;
+		rest += 4;
+		size -= 4;
+	}
+	for (; size != 0; ++rest, --size) {
+		hash = std::rotl(hash ^ (uint64_t {static_cast<unsigned char>(*rest)} * prime5), 11) * prime1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= prime2;
+	hash ^= hash >> 29;
+	hash *= prime3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+void ContentHash::update(uint64_t offset, std::string_view data)
+{
+	if (gap || offset + data.size() <= hashed) {
+		return;
+	}
+	if (offset > hashed) {
+		gap = true;
+		return;
+	}
+	state.update(data.substr(hashed - offset));
+	hashed = offset + data.size();
+}
+
+bool ContentHash::finish(uint64_t &hash, uint64_t &size) const
+{
+	if (gap) {
+		return false;
+	}
+	hash = state.digest();
+	size = hashed;
+	return true;
+}
+
+bool ContentHash::hashFile(std::string const &fileName, uint64_t size, uint64_t &hash)
+{
+	std::ifstream file(fileName, std::ios_base::in | std::ios_base::binary);
+	if (!file.is_open()) {
+		return false;
+	}
+	Xxh64 state;
+	size_t const chunkSize = size_t {1} << 20;
+	auto const chunk = std::make_unique<char[]>(chunkSize);
+	while (size != 0) {
+		size_t const wanted = static_cast<size_t>(std::min<uint64_t>(size, chunkSize));
+		if (!file.read(chunk.get(), static_cast<std::streamsize>(wanted))) {
+			return false;
+		}
+		state.update({chunk.get(), wanted});
+		size -= wanted;
+	}
+	hash = state.digest();
+	return true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Streaming XXH64, with the output of the reference implementation
+class Xxh64 {
+public:
+	explicit Xxh64(uint64_t seed = 0);
+
+	void update(std::string_view data);
+	uint64_t digest() const;
+
+private:
+	std::array<uint64_t, 4> lanes;
+	// Input short of a full 32-byte stripe
+	std::array<char, 32> pending {};
+	size_t pendingSize = 0;
+	uint64_t totalSize = 0;
+	uint64_t seed;
+};
+
+// Hash of the first bytes of a file, computed from the pieces validation reads anyway: the blocks the read-ahead
+// hands to the decompressor (ReadAheadBuffer::setBlockObserver) or the lines of a mapping as they are validated. It
+// covers what was read, so a run that stops early hashes only the part of the file it got to and never reads on.
+class ContentHash {
+public:
+	// The part of data, the bytes of the file at offset, that is past what was hashed so far. Data beyond that
+	// leaves a gap, after which the hash covers nothing validation read and finish() fails.
+	void update(uint64_t offset, std::string_view data);
+	// For input read without update() seeing it, so that finish() fails as after a gap
+	void leaveGap()
+	{
+		gap = true;
+	}
+	// XXH64 of the bytes hashed and their count from the start of the file, false after a gap
+	bool finish(uint64_t &hash, uint64_t &size) const;
+
+	// XXH64 of the first size bytes of fileName, false if it cannot be read or is shorter
+	static bool hashFile(std::string const &fileName, uint64_t size, uint64_t &hash);
+
+private:
+	Xxh64 state;
+	uint64_t hashed = 0;
+	bool gap = false;
+};
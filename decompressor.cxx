@@ -0,0 +1,568 @@
+#include "decompressor.hxx"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <istream>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+#ifdef GENOMIC_VALIDATOR_WITH_LIBDEFLATE
+#	include <libdeflate.h>
+#endif
+#ifdef GENOMIC_VALIDATOR_WITH_BZIP2
+#	include <bzlib.h>
+#endif
+#ifdef GENOMIC_VALIDATOR_WITH_ZSTD
+#	include <zstd.h>
+#endif
+
+namespace {
+
+class ZlibInflater final : public BlockInflater {
+public:
+	ZlibInflater()
+	{
+		if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+			throw std::runtime_error("Failed to initialize zlib");
+		}
+	}
+	~ZlibInflater() override
+	{
+		inflateEnd(&stream);
+	}
+	ZlibInflater(ZlibInflater const &) = delete;
+	ZlibInflater &operator=(ZlibInflater const &) = delete;
+
+	bool inflate(std::span<unsigned char const> deflated, std::span<char> out, uint32_t crc) override
+	{
+		inflateReset(&stream);
+		stream.next_in = const_cast<Bytef *>(deflated.data());
+		stream.avail_in = static_cast<uInt>(deflated.size());
+		stream.next_out = reinterpret_cast<Bytef *>(out.data());
+		stream.avail_out = static_cast<uInt>(out.size());
+		return ::inflate(&stream, Z_FINISH) == Z_STREAM_END && stream.avail_out == 0
+			&& crc32(0, reinterpret_cast<Bytef const *>(out.data()), static_cast<uInt>(out.size())) == crc;
+	}
+
+private:
+	z_stream stream {};
+};
+
+#ifdef GENOMIC_VALIDATOR_WITH_LIBDEFLATE
+// Inflates a block in one call, with no streaming state to carry between refills, and checks the CRC32 with
+// carry-less multiplication where the CPU has it
+class LibdeflateInflater final : public BlockInflater {
+public:
+	LibdeflateInflater()
+		: decompressor(libdeflate_alloc_decompressor())
+	{
+		if (decompressor == nullptr) {
+			throw std::bad_alloc();
+		}
+	}
+	~LibdeflateInflater() override
+	{
+		libdeflate_free_decompressor(decompressor);
+	}
+	LibdeflateInflater(LibdeflateInflater const &) = delete;
+	LibdeflateInflater &operator=(LibdeflateInflater const &) = delete;
+
+	bool inflate(std::span<unsigned char const> deflated, std::span<char> out, uint32_t crc) override
+	{
+		size_t inflated = 0;
+		return libdeflate_deflate_decompress(
+				   decompressor, deflated.data(), deflated.size(), out.data(), out.size(), &inflated)
+			== LIBDEFLATE_SUCCESS
+			&& inflated == out.size() && libdeflate_crc32(0, out.data(), out.size()) == crc;
+	}
+
+private:
+	libdeflate_decompressor *decompressor;
+};
+#endif
+
+constexpr std::string_view backendNames[] = {
+#ifdef GENOMIC_VALIDATOR_WITH_LIBDEFLATE
+	"libdeflate",
+#endif
+	"zlib",
+};
+
+// No backend chosen yet, neither by selectInflateBackend() nor by probing
+constexpr size_t unprobedBackend = SIZE_MAX;
+std::atomic<size_t> selectedBackend = unprobedBackend;
+std::once_flag probeOnce;
+
+std::unique_ptr<BlockInflater> makeInflater(std::string_view name)
+{
+#ifdef GENOMIC_VALIDATOR_WITH_LIBDEFLATE
+	if (name == "libdeflate") {
+		return std::make_unique<LibdeflateInflater>();
+	}
+#endif
+	(void)name;
+	return std::make_unique<ZlibInflater>();
+}
+
+// A BGZF block's worth of data lines, raw deflated, for the backends to be timed on
+struct ProbeBlock {
+	std::string text;
+	std::vector<unsigned char> deflated;
+	uint32_t crc = 0;
+};
+
+bool makeProbeBlock(ProbeBlock &block)
+{
+	constexpr size_t size = 0xff00;
+	for (unsigned record = 0; block.text.size() < size; ++record) {
+		block.text.append("chr1\t").append(std::to_string(10000 + record * 37));
+		block.text.append("\t.\tA\tG\t").append(std::to_string(record % 97));
+		block.text.append("\tPASS\tDP=").append(std::to_string(record % 211));
+		block.text.append("\tGT:DP\t0/1:").append(std::to_string(record % 53));
+		block.text.append("\t1/1:").append(std::to_string(record % 29)).push_back('\n');
+	}
+	block.text.resize(size);
+	block.crc = crc32(0, reinterpret_cast<Bytef const *>(block.text.data()), static_cast<uInt>(size));
+
+	z_stream stream {};
+	if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+		return false;
+	}
+	block.deflated.resize(deflateBound(&stream, static_cast<uLong>(size)));
+	stream.next_in = reinterpret_cast<Bytef *>(block.text.data());
+	stream.avail_in = static_cast<uInt>(size);
+	stream.next_out = block.deflated.data();
+	stream.avail_out = static_cast<uInt>(block.deflated.size());
+	bool const deflated = ::deflate(&stream, Z_FINISH) == Z_STREAM_END;
+	block.deflated.resize(stream.total_out);
+	deflateEnd(&stream);
+	return deflated;
+}
+
+// Index of the backend that inflates a sample block fastest, of those that initialize on this host and inflate it
+// correctly; the last, zlib, if none of the others does
+size_t probeBackends()
+{
+	constexpr size_t backendCount = std::size(backendNames);
+	constexpr int rounds = 8;
+	ProbeBlock block;
+	if (backendCount == 1 || !makeProbeBlock(block)) {
+		return backendCount - 1;
+	}
+	std::vector<char> out(block.text.size());
+	size_t fastest = backendCount - 1;
+	auto fastestTime = std::chrono::steady_clock::duration::max();
+	for (size_t backend = 0; backend < backendCount; ++backend) {
+		try {
+			auto const inflater = makeInflater(backendNames[backend]);
+			// The first round warms up the inflater's tables and is not timed
+			bool correct = inflater->inflate(block.deflated, out, block.crc);
+			auto const start = std::chrono::steady_clock::now();
+			for (int round = 0; round < rounds && correct; ++round) {
+				correct = inflater->inflate(block.deflated, out, block.crc);
+			}
+			auto const elapsed = std::chrono::steady_clock::now() - start;
+			if (correct && std::string_view(out.data(), out.size()) == block.text && elapsed < fastestTime) {
+				fastest = backend;
+				fastestTime = elapsed;
+			}
+		} catch (std::exception const &) {
+			// A backend that cannot be set up here is not a candidate
+		}
+	}
+	return fastest;
+}
+
+// The selected backend, probed for on first use unless one was selected before
+size_t currentBackend()
+{
+	size_t const selected = selectedBackend.load(std::memory_order_acquire);
+	if (selected != unprobedBackend) {
+		return selected;
+	}
+	std::call_once(probeOnce, [] {
+		size_t unprobed = unprobedBackend;
+		selectedBackend.compare_exchange_strong(unprobed, probeBackends(), std::memory_order_acq_rel);
+	});
+	return selectedBackend.load(std::memory_order_acquire);
+}
+
+// Decoder of a whole compressed stream. What was decoded ahead of malformed input is still handed out; the error is
+// thrown by the read after it.
+class StreamDecompressor : public Decompressor {
+public:
+	size_t read(char *buffer, size_t size) final
+	{
+		if (failure != nullptr) {
+			throw std::runtime_error(failure);
+		}
+		size_t const decoded = decode(buffer, size);
+		if (decoded == 0 && failure != nullptr) {
+			throw std::runtime_error(failure);
+		}
+		return decoded;
+	}
+
+protected:
+	// Decodes up to size bytes; on malformed input sets failure and returns what was decoded before it
+	virtual size_t decode(char *buffer, size_t size) = 0;
+
+	char const *failure = nullptr;
+};
+
+// Compressed bytes taken from the stream in large pieces, straight from its buffer
+class CompressedInput {
+public:
+	explicit CompressedInput(std::istream &in)
+		: in(in)
+	{
+	}
+
+	// Consumes the rest of the previous piece and reads the next, false at the end of the input
+	bool refill()
+	{
+		size = static_cast<size_t>(in.rdbuf()->sgetn(data.data(), static_cast<std::streamsize>(data.size())));
+		return size != 0;
+	}
+	char *begin()
+	{
+		return data.data();
+	}
+
+	size_t size = 0;
+
+private:
+	std::istream &in;
+	std::array<char, size_t {64} << 10> data;
+};
+
+// gzip members decoded one after another, as gzip -d does with concatenated files
+class GzipDecompressor final : public StreamDecompressor {
+public:
+	explicit GzipDecompressor(std::istream &compressed)
+		: input(compressed)
+	{
+		if (inflateInit2(&stream, MAX_WBITS + 16) != Z_OK) {
+			throw std::runtime_error("Failed to initialize zlib");
+		}
+	}
+	~GzipDecompressor() override
+	{
+		inflateEnd(&stream);
+	}
+	GzipDecompressor(GzipDecompressor const &) = delete;
+	GzipDecompressor &operator=(GzipDecompressor const &) = delete;
+
+	size_t decode(char *buffer, size_t size) override
+	{
+		stream.next_out = reinterpret_cast<Bytef *>(buffer);
+		stream.avail_out = static_cast<uInt>(std::min<size_t>(size, UINT32_MAX));
+		while (stream.avail_out != 0 && !ended) {
+			if (stream.avail_in == 0) {
+				if (!input.refill()) {
+					if (inMember) {
+						failure = "Truncated gzip stream";
+						break;
+					}
+					ended = true;
+					break;
+				}
+				stream.next_in = reinterpret_cast<Bytef *>(input.begin());
+				stream.avail_in = static_cast<uInt>(input.size);
+			}
+			inMember = true;
+			int const status = ::inflate(&stream, Z_NO_FLUSH);
+			if (status == Z_STREAM_END) {
+				inMember = false;
+				inflateReset(&stream);
+			} else if (status != Z_OK) {
+				failure = "Corrupt gzip stream";
+				break;
+			}
+		}
+		return static_cast<size_t>(reinterpret_cast<char *>(stream.next_out) - buffer);
+	}
+
+private:
+	CompressedInput input;
+	z_stream stream {};
+	bool inMember = false;
+	bool ended = false;
+};
+
+#ifdef GENOMIC_VALIDATOR_WITH_BZIP2
+// bzip2 streams decoded one after another, like pbzip2 output
+class Bzip2Decompressor final : public StreamDecompressor {
+public:
+	explicit Bzip2Decompressor(std::istream &compressed)
+		: input(compressed)
+	{
+		initialize();
+	}
+	~Bzip2Decompressor() override
+	{
+		BZ2_bzDecompressEnd(&stream);
+	}
+	Bzip2Decompressor(Bzip2Decompressor const &) = delete;
+	Bzip2Decompressor &operator=(Bzip2Decompressor const &) = delete;
+
+	size_t decode(char *buffer, size_t size) override
+	{
+		stream.next_out = buffer;
+		stream.avail_out = static_cast<unsigned>(std::min<size_t>(size, UINT32_MAX));
+		while (stream.avail_out != 0 && !ended) {
+			if (stream.avail_in == 0) {
+				if (!input.refill()) {
+					if (inStream) {
+						failure = "Truncated bzip2 stream";
+						break;
+					}
+					ended = true;
+					break;
+				}
+				stream.next_in = input.begin();
+				stream.avail_in = static_cast<unsigned>(input.size);
+			}
+			inStream = true;
+			int const status = BZ2_bzDecompress(&stream);
+			if (status == BZ_STREAM_END) {
+				// The next stream starts with what is left of the input
+				char *const next = stream.next_in;
+				unsigned const available = stream.avail_in;
+				char *const out = stream.next_out;
+				unsigned const room = stream.avail_out;
+				BZ2_bzDecompressEnd(&stream);
+				initialize();
+				stream.next_in = next;
+				stream.avail_in = available;
+				stream.next_out = out;
+				stream.avail_out = room;
+				inStream = false;
+			} else if (status != BZ_OK) {
+				failure = "Corrupt bzip2 stream";
+				break;
+			}
+		}
+		return static_cast<size_t>(stream.next_out - buffer);
+	}
+
+private:
+	void initialize()
+	{
+		stream = {};
+		if (BZ2_bzDecompressInit(&stream, 0, 0) != BZ_OK) {
+			throw std::runtime_error("Failed to initialize bzip2");
+		}
+	}
+
+	CompressedInput input;
+	bz_stream stream {};
+	bool inStream = false;
+	bool ended = false;
+};
+#endif
+
+#ifdef GENOMIC_VALIDATOR_WITH_ZSTD
+// Zstandard frames, which ZSTD_decompressStream already decodes one after another
+class ZstdDecompressor final : public StreamDecompressor {
+public:
+	explicit ZstdDecompressor(std::istream &compressed)
+		: input(compressed)
+		, stream(ZSTD_createDStream())
+	{
+		if (stream == nullptr) {
+			throw std::bad_alloc();
+		}
+		ZSTD_initDStream(stream);
+	}
+	~ZstdDecompressor() override
+	{
+		ZSTD_freeDStream(stream);
+	}
+	ZstdDecompressor(ZstdDecompressor const &) = delete;
+	ZstdDecompressor &operator=(ZstdDecompressor const &) = delete;
+
+	size_t decode(char *buffer, size_t size) override
+	{
+		ZSTD_outBuffer out {buffer, size, 0};
+		while (out.pos != out.size && !ended) {
+			if (in.pos == in.size) {
+				if (!input.refill()) {
+					if (inFrame) {
+						failure = "Truncated zstd stream";
+						break;
+					}
+					ended = true;
+					break;
+				}
+				in = {input.begin(), input.size, 0};
+			}
+			size_t const hint = ZSTD_decompressStream(stream, &out, &in);
+			if (ZSTD_isError(hint) != 0) {
+				failure = "Corrupt zstd stream";
+				break;
+			}
+			// 0 once a frame is complete and flushed
+			inFrame = hint != 0;
+		}
+		return out.pos;
+	}
+
+private:
+	CompressedInput input;
+	ZSTD_DStream *stream;
+	ZSTD_inBuffer in {nullptr, 0, 0};
+	bool inFrame = false;
+	bool ended = false;
+};
+#endif
+
+} // namespace
+
+std::span<std::string_view const> inflateBackends()
+{
+	return backendNames;
+}
+
+bool selectInflateBackend(std::string_view name)
+{
+	auto const found = std::ranges::find(backendNames, name);
+	if (found == std::end(backendNames)) {
+		return false;
+	}
+	selectedBackend.store(static_cast<size_t>(found - std::begin(backendNames)), std::memory_order_release);
+	return true;
+}
+
+std::string_view inflateBackend()
+{
+	return backendNames[currentBackend()];
+}
+
+BlockInflater &threadInflater()
+{
+	thread_local std::unique_ptr<BlockInflater> inflater;
+	thread_local size_t backend = 0;
+	size_t const selected = currentBackend();
+	if (!inflater || backend != selected) {
+		inflater = makeInflater(backendNames[selected]);
+		backend = selected;
+	}
+	return *inflater;
+}
+
+CompressionFormat detectCompression(std::istream &compressed)
+{
+	std::array<unsigned char, 4> magic {};
+	auto const start = compressed.tellg();
+	compressed.read(reinterpret_cast<char *>(magic.data()), magic.size());
+	auto const size = static_cast<size_t>(compressed.gcount());
+	compressed.clear();
+	compressed.seekg(start);
+
+	if (size >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) {
+		return CompressionFormat::Gzip;
+	}
+	if (size >= 3 && magic[0] == 'B' && magic[1] == 'Z' && magic[2] == 'h') {
+		return CompressionFormat::Bzip2;
+	}
+	if (size == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) {
+		return CompressionFormat::Zstd;
+	}
+	return CompressionFormat::Unknown;
+}
+
+char const *compressionName(CompressionFormat format)
+{
+	switch (format) {
+	case CompressionFormat::Gzip:
+		return "gzip";
+	case CompressionFormat::Bzip2:
+		return "bzip2";
+	case CompressionFormat::Zstd:
+		return "zstd";
+	case CompressionFormat::Unknown:
+		break;
+	}
+	return "unknown";
+}
+
+std::unique_ptr<Decompressor> makeStreamDecompressor(CompressionFormat format, std::istream &compressed)
+{
+	switch (format) {
+	case CompressionFormat::Bzip2:
+#ifdef GENOMIC_VALIDATOR_WITH_BZIP2
+		return std::make_unique<Bzip2Decompressor>(compressed);
+#else
+		return nullptr;
+#endif
+	case CompressionFormat::Zstd:
+#ifdef GENOMIC_VALIDATOR_WITH_ZSTD
+		return std::make_unique<ZstdDecompressor>(compressed);
+#else
+		return nullptr;
+#endif
+	case CompressionFormat::Gzip:
+	case CompressionFormat::Unknown:
+		break;
+	}
+	return std::make_unique<GzipDecompressor>(compressed);
+}
+
+DecompressedBuffer::DecompressedBuffer(Decompressor &source, size_t bufferSize)
+	: source(source)
+	, buffer(bufferSize)
+{
+}
+
+DecompressedBuffer::int_type DecompressedBuffer::underflow()
+{
+	if (gptr() < egptr()) {
+		return traits_type::to_int_type(*gptr());
+	}
+	size_t const size = source.read(buffer.data(), buffer.size());
+	setg(buffer.data(), buffer.data(), buffer.data() + size);
+	return size != 0 ? traits_type::to_int_type(*gptr()) : traits_type::eof();
+}
+
+std::streamsize DecompressedBuffer::xsgetn(char *out, std::streamsize size)
+{
+	// What is buffered first, then reads of at least a buffer's worth go straight to the caller
+	auto const wanted = static_cast<size_t>(size);
+	size_t copied = std::min(wanted, static_cast<size_t>(egptr() - gptr()));
+	std::memcpy(out, gptr(), copied);
+	gbump(static_cast<int>(copied));
+	try {
+		while (copied < wanted) {
+			if (wanted - copied < buffer.size()) {
+				if (traits_type::eq_int_type(underflow(), traits_type::eof())) {
+					break;
+				}
+				size_t const count = std::min(wanted - copied, static_cast<size_t>(egptr() - gptr()));
+				std::memcpy(out + copied, gptr(), count);
+				gbump(static_cast<int>(count));
+				copied += count;
+				continue;
+			}
+			size_t const count = source.read(out + copied, wanted - copied);
+			if (count == 0) {
+				break;
+			}
+			copied += count;
+		}
+	} catch (...) {
+		// The bytes before the error are handed out first; the decompressor throws again on the next read
+		if (copied == 0) {
+			throw;
+		}
+	}
+	return static_cast<std::streamsize>(copied);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <span>
+#include <streambuf>
+#include <string_view>
+#include <vector>
+
+// Inflates whole BGZF blocks: raw deflate data whose inflated size and CRC32 the block's footer gives. Backends are
+// zlib, always, and libdeflate where the build found it (GENOMIC_VALIDATOR_WITH_LIBDEFLATE); zlib-ng in its zlib
+// compatible build replaces zlib at link time.
+class BlockInflater {
+public:
+	virtual ~BlockInflater() = default;
+
+	// Inflates deflated into exactly out.size() bytes, false if the data is corrupt or its CRC32 is not crc
+	virtual bool inflate(std::span<unsigned char const> deflated, std::span<char> out, uint32_t crc) = 0;
+};
+
+// Names of the BlockInflater backends built in, zlib last
+std::span<std::string_view const> inflateBackends();
+// Makes BGZF inflation use the named backend from now on, false if it is not built in. Unless one is selected, the
+// first use probes the backends on this host: each that initializes inflates a sample block, and the one that does
+// so correctly in the least time is used.
+bool selectInflateBackend(std::string_view name);
+std::string_view inflateBackend();
+// The selected backend's inflater for the calling thread, made on first use and kept for the thread's blocks
+BlockInflater &threadInflater();
+
+// Source of decompressed bytes read through a DecompressedBuffer
+class Decompressor {
+public:
+	virtual ~Decompressor() = default;
+
+	// Copies up to size decompressed bytes in input order, returns 0 at the end of the input.
+	// Throws std::runtime_error on malformed, truncated or corrupt input, and again on every read after that.
+	virtual size_t read(char *buffer, size_t size) = 0;
+};
+
+enum class CompressionFormat
+{
+	Gzip,
+	Bzip2,
+	Zstd,
+	Unknown,
+};
+
+// Format of the stream from its first bytes. The stream is rewound to where it was.
+CompressionFormat detectCompression(std::istream &compressed);
+char const *compressionName(CompressionFormat format);
+
+// Decompresses the whole of compressed as one stream of format, concatenated members or frames included; nullptr if
+// support for format is not built in (bzip2: GENOMIC_VALIDATOR_WITH_BZIP2, zstd: GENOMIC_VALIDATOR_WITH_ZSTD).
+// Unknown input is handed to the gzip decoder, which rejects it.
+std::unique_ptr<Decompressor> makeStreamDecompressor(CompressionFormat format, std::istream &compressed);
+
+// Input stream buffer refilled from a Decompressor in bufferSize pieces. An exception from the decompressor
+// propagates out of underflow(), which std::istream turns into badbit.
+class DecompressedBuffer final : public std::streambuf {
+public:
+	explicit DecompressedBuffer(Decompressor &source, size_t bufferSize = size_t {64} << 10);
+
+protected:
+	int_type underflow() override;
+	std::streamsize xsgetn(char *buffer, std::streamsize size) override;
+
+private:
+	Decompressor &source;
+	std::vector<char> buffer;
+};
@@ -0,0 +1,228 @@
+#include "error_sink.hxx"
+
+#include "vcf_validation.hxx"
+
+#include <algorithm>
+#include <iterator>
+#include <ostream>
+
+#include <fmt/format.h>
+
+namespace {
+
+thread_local ErrorSink *currentSink = nullptr;
+
+// Errors buffered before the collector formats and prints them
+constexpr size_t collectorBatch = 1024;
+
+struct ErrorDescription {
+	uint32_t column;
+	std::string_view field;
+	std::string_view message;
+};
+
+constexpr ErrorDescription describe(ErrorCode code)
+{
+	switch (code) {
+	case ErrorCode::InvalidFileFormat:
+		return {0, "fileformat", "Invalid file format version: "};
+	case ErrorCode::InvalidContigLine:
+		return {0, "contig", "Invalid contig line: "};
+	case ErrorCode::InvalidAltLine:
+		return {0, "ALT", "Invalid ALT line: "};
+	case ErrorCode::InvalidSampleOrPedigreeLine:
+		return {0, "SAMPLE", "Invalid SAMPLE or PEDIGREE line: "};
+	case ErrorCode::InvalidInfoOrFormatLine:
+		return {0, "INFO", "Invalid INFO or FORMAT line: "};
+	case ErrorCode::InvalidFilterLine:
+		return {0, "FILTER", "Invalid FILTER line: "};
+	case ErrorCode::UnknownHeaderFormat:
+		return {0, "header", "Unknown header format: "};
+	case ErrorCode::InsufficientTitleColumns:
+		return {0, "#CHROM", "Insufficient columns in title line."};
+	case ErrorCode::InvalidTitleLine:
+		return {0, "#CHROM", "Invalid column header line: "};
+	case ErrorCode::UnknownSample:
+		return {0, "#CHROM", "Sample not in column header line: "};
+	case ErrorCode::UnexpectedLine:
+		return {0, "header", "Unexpected line format: "};
+	case ErrorCode::MissingTitleLine:
+		return {0, "header", "Missing column header line."};
+	case ErrorCode::NotEnoughFields:
+		return {0, "line", "Invalid data line (not enough fields): "};
+	case ErrorCode::InvalidChrom:
+		return {1, "CHROM", "Invalid CHROM field: "};
+	case ErrorCode::NonHumanChromosome:
+		return {1, "CHROM", "Non-human chromosome found: "};
+	case ErrorCode::UndeclaredContig:
+		return {1, "CHROM", "Contig not declared in header: "};
+	case ErrorCode::NonContiguousContig:
+		return {1, "CHROM", "Records of contig not contiguous: "};
+	case ErrorCode::InvalidPos:
+		return {2, "POS", "Invalid POS field: "};
+	case ErrorCode::PosNotInteger:
+		return {2, "POS", "Invalid POS field (not an integer): "};
+	case ErrorCode::PosBeyondContigLength:
+		return {2, "POS", "POS beyond contig length: "};
+	case ErrorCode::UnsortedPos:
+		return {2, "POS", "Records not sorted by POS: "};
+	case ErrorCode::InvalidId:
+		return {3, "ID", "Invalid ID field: "};
+	case ErrorCode::InvalidRef:
+		return {4, "REF", "Invalid REF field: "};
+	case ErrorCode::InvalidAlt:
+		return {5, "ALT", "Invalid ALT field: "};
+	case ErrorCode::InvalidQual:
+		return {6, "QUAL", "Invalid QUAL field: "};
+	case ErrorCode::QualNotFloat:
+		return {6, "QUAL", "Invalid QUAL field (not a float): "};
+	case ErrorCode::InvalidFilter:
+		return {7, "FILTER", "Invalid FILTER field: "};
+	case ErrorCode::InvalidInfo:
+		return {8, "INFO", "Invalid INFO field: "};
+	case ErrorCode::InvalidInfoValue:
+		return {8, "INFO", "Invalid INFO entry: "};
+	case ErrorCode::FormatMissing:
+		return {9, "FORMAT", "FORMAT field missing or invalid"};
+	case ErrorCode::SampleFieldCountMismatch:
+		return {9, "FORMAT", "Sample data does not match FORMAT descriptors"};
+	case ErrorCode::InvalidSampleValue:
+		break;
+	}
+	return {9, "FORMAT", "Invalid sample data: "};
+}
+
+void deliver(ErrorCode code, uint32_t column, std::string_view field, std::string_view message, std::string_view value)
+{
+	if (currentSink != nullptr) {
+		currentSink->record(code, column, field, message, value);
+		return;
+	}
+	diagnostics() << message << value << '\n';
+}
+
+} // namespace
+
+ErrorSink::ErrorSink(size_t capacity)
+	: storage(std::make_unique_for_overwrite<ValidationError[]>(std::max<size_t>(capacity, 1)))
+	, capacity(std::max<size_t>(capacity, 1))
+{
+}
+
+void ErrorSink::record(
+	ErrorCode code, uint32_t column, std::string_view field, std::string_view message, std::string_view value)
+{
+	if (full()) {
+		++droppedCount;
+		return;
+	}
+	ValidationError &error = storage[count++];
+	error.line = currentLine;
+	error.column = column;
+	error.code = code;
+	error.field = field;
+	error.message = message;
+	error.truncated = value.size() > ValidationError::maxValueSize;
+	error.valueSize = static_cast<uint16_t>(std::min(value.size(), ValidationError::maxValueSize));
+	std::copy_n(value.data(), error.valueSize, error.value.data());
+}
+
+void ErrorSink::append(ValidationError const &error, uint64_t line)
+{
+	if (full()) {
+		++droppedCount;
+		return;
+	}
+	ValidationError &copy = storage[count++];
+	copy = error;
+	copy.line = line;
+}
+
+ErrorSinkScope::ErrorSinkScope(ErrorSink &sink)
+	: previous(currentSink)
+{
+	currentSink = &sink;
+}
+
+ErrorSinkScope::~ErrorSinkScope()
+{
+	currentSink = previous;
+}
+
+void reportError(ErrorCode code, std::string_view value, uint32_t column)
+{
+	ErrorDescription const description = describe(code);
+	deliver(code, column != 0 ? column : description.column, description.field, description.message, value);
+}
+
+void reportSampleError(size_t sample, std::string_view key, std::string_view message, std::string_view value)
+{
+	deliver(ErrorCode::InvalidSampleValue, sampleColumn(sample), key, message, value);
+}
+
+void reportInfoError(std::string_view key, std::string_view message, std::string_view entry)
+{
+	deliver(ErrorCode::InvalidInfoValue, describe(ErrorCode::InvalidInfoValue).column, key, message, entry);
+}
+
+void formatErrors(std::span<ValidationError const> errors, bool withLocations, std::string &out)
+{
+	auto inserter = std::back_inserter(out);
+	for (auto const &error : errors) {
+		// Errors found without reading the file from its start (region validation) have no line number
+		if (withLocations && error.line != 0) {
+			if (error.column != 0) {
+				fmt::format_to(inserter, "{}:{}: ", error.line, error.column);
+			} else {
+				fmt::format_to(inserter, "{}: ", error.line);
+			}
+		}
+		fmt::format_to(inserter, "{}{}{}\n", error.message, error.valueText(), error.truncated ? "..." : "");
+	}
+}
+
+ErrorCollector::ErrorCollector(size_t maxErrors)
+	: limit(std::max<size_t>(maxErrors, 1))
+	, pending(std::min(limit, collectorBatch))
+{
+}
+
+ErrorCollector::~ErrorCollector()
+{
+	flush();
+}
+
+bool ErrorCollector::lineFailed()
+{
+	++failedLines;
+	if (pending.full()) {
+		flush();
+	}
+	return !limitReached();
+}
+
+bool ErrorCollector::merge(std::span<ValidationError const> errors, uint64_t lineOffset)
+{
+	for (auto const &error : errors) {
+		if (limitReached()) {
+			break;
+		}
+		pending.append(error, lineOffset + error.line);
+		++failedLines;
+		if (pending.full()) {
+			flush();
+		}
+	}
+	return !limitReached();
+}
+
+void ErrorCollector::flush()
+{
+	if (pending.errors().empty()) {
+		return;
+	}
+	text.clear();
+	formatErrors(pending.errors(), limit != 1, text);
+	pending.clear();
+	diagnostics() << text;
+}
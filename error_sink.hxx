@@ -0,0 +1,185 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+
+// One code per message a validator can report
+enum class ErrorCode : uint8_t
+{
+	InvalidFileFormat,
+	InvalidContigLine,
+	InvalidAltLine,
+	InvalidSampleOrPedigreeLine,
+	InvalidInfoOrFormatLine,
+	InvalidFilterLine,
+	UnknownHeaderFormat,
+	InsufficientTitleColumns,
+	InvalidTitleLine,
+	UnknownSample, // --samples names a sample the column header line does not have
+	UnexpectedLine,
+	MissingTitleLine,
+	NotEnoughFields,
+	InvalidChrom,
+	NonHumanChromosome,
+	UndeclaredContig,
+	NonContiguousContig,
+	InvalidPos,
+	PosNotInteger,
+	PosBeyondContigLength,
+	UnsortedPos,
+	InvalidId,
+	InvalidRef,
+	InvalidAlt,
+	InvalidQual,
+	QualNotFloat,
+	InvalidFilter,
+	InvalidInfo,
+	InvalidInfoValue, // Field and message come from the INFO key's declaration
+	FormatMissing,
+	SampleFieldCountMismatch,
+	InvalidSampleValue, // Field and message come from the FORMAT key's check
+};
+
+// A reported problem. Fixed size, so sinks can hold them without allocating; long values are cut.
+struct ValidationError {
+	static constexpr size_t maxValueSize = 240;
+
+	uint64_t line = 0; // 1-based, 0 when validating a single line on its own
+	uint32_t column = 0; // 1-based VCF column, 0 for the whole line
+	ErrorCode code {};
+	bool truncated = false;
+	uint16_t valueSize = 0;
+	// Static strings: the column or FORMAT key name and the message printed in front of the value
+	std::string_view field;
+	std::string_view message;
+	std::array<char, maxValueSize> value;
+
+	std::string_view valueText() const
+	{
+		return {value.data(), valueSize};
+	}
+};
+
+// Bounded buffer of errors for one thread, its storage is allocated once up front
+class ErrorSink {
+public:
+	explicit ErrorSink(size_t capacity);
+
+	// Line number given to the errors recorded from now on
+	void setLine(uint64_t line)
+	{
+		currentLine = line;
+	}
+
+	// Errors arriving while the sink is full are counted in dropped() only
+	void record(ErrorCode code, uint32_t column, std::string_view field, std::string_view message,
+		std::string_view value);
+	// Copies an error recorded elsewhere, renumbered to line
+	void append(ValidationError const &error, uint64_t line);
+
+	std::span<ValidationError const> errors() const
+	{
+		return {storage.get(), count};
+	}
+	bool full() const
+	{
+		return count == capacity;
+	}
+	size_t dropped() const
+	{
+		return droppedCount;
+	}
+	void clear()
+	{
+		count = 0;
+		droppedCount = 0;
+	}
+
+private:
+	std::unique_ptr<ValidationError[]> storage;
+	size_t capacity;
+	size_t count = 0;
+	size_t droppedCount = 0;
+	uint64_t currentLine = 0;
+};
+
+// Sends the errors reported on the current thread to sink while in scope
+class ErrorSinkScope {
+public:
+	explicit ErrorSinkScope(ErrorSink &sink);
+	~ErrorSinkScope();
+
+	ErrorSinkScope(ErrorSinkScope const &) = delete;
+	ErrorSinkScope &operator=(ErrorSinkScope const &) = delete;
+
+private:
+	ErrorSink *previous;
+};
+
+// Records an error in the calling thread's sink, or prints it to diagnostics() right away when there is none.
+// column 0 picks the column the code belongs to.
+void reportError(ErrorCode code, std::string_view value = {}, uint32_t column = 0);
+// An invalid value in the 0-based sample column sample, for the FORMAT key described by key and message
+void reportSampleError(size_t sample, std::string_view key, std::string_view message, std::string_view value);
+
+// An invalid entry of the INFO column, for the declared INFO key described by key and message
+void reportInfoError(std::string_view key, std::string_view message, std::string_view entry);
+
+// VCF column of a sample, counting from 1 like the rest of the error locations
+constexpr uint32_t sampleColumn(size_t sample)
+{
+	return static_cast<uint32_t>(10 + sample);
+}
+
+// Appends errors to out as text, one per line; with locations each that has a line number starts with
+// "line:column: "
+void formatErrors(std::span<ValidationError const> errors, bool withLocations, std::string &out);
+
+// Gathers the errors of a whole file in input order, stops it after maxErrors and prints them lazily
+class ErrorCollector {
+public:
+	// maxErrors 1 is fail-fast and prints errors without locations, exactly like a single validator would
+	explicit ErrorCollector(size_t maxErrors);
+	~ErrorCollector();
+
+	ErrorCollector(ErrorCollector const &) = delete;
+	ErrorCollector &operator=(ErrorCollector const &) = delete;
+
+	// Sink for the collecting thread, install it with ErrorSinkScope and number lines with setLine()
+	ErrorSink &sink()
+	{
+		return pending;
+	}
+	// Call after a line recorded into sink() failed; false once maxErrors lines have failed
+	bool lineFailed();
+	// Takes errors recorded on another thread whose line numbers count from lineOffset + 1; false once maxErrors
+	// lines have failed, later errors are ignored
+	bool merge(std::span<ValidationError const> errors, uint64_t lineOffset);
+
+	size_t maxErrors() const
+	{
+		return limit;
+	}
+	size_t errorCount() const
+	{
+		return failedLines;
+	}
+	bool limitReached() const
+	{
+		return failedLines >= limit;
+	}
+
+	// Formats and prints the errors collected so far to diagnostics()
+	void flush();
+
+private:
+	size_t limit;
+	size_t failedLines = 0;
+	ErrorSink pending;
+	std::string text;
+};
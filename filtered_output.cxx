@@ -0,0 +1,337 @@
+#include "filtered_output.hxx"
+
+#include "bgzf_writer.hxx"
+#include "thread_pool.hxx"
+#include "validation_stats.hxx"
+#include "vcf_validation.hxx"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace {
+
+// Writes all of data to fd, false if writing fails
+bool writeAll(int fd, char const *data, size_t size)
+{
+	while (size != 0) {
+		ssize_t const written = ::write(fd, data, size);
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		data += written;
+		size -= static_cast<size_t>(written);
+	}
+	return true;
+}
+
+// A descriptor that is closed with the writer unless it is stdout
+class OutputFile {
+public:
+	OutputFile(int fd, bool owned)
+		: fd(fd)
+		, owned(owned)
+	{
+	}
+	~OutputFile()
+	{
+		close();
+	}
+
+	OutputFile(OutputFile const &) = delete;
+	OutputFile &operator=(OutputFile const &) = delete;
+
+	int descriptor() const
+	{
+		return fd;
+	}
+	// False if the data written may not have reached the file
+	bool close()
+	{
+		bool closed = true;
+		if (owned) {
+			closed = ::close(fd) == 0;
+			owned = false;
+		}
+		return closed;
+	}
+
+private:
+	int fd;
+	bool owned;
+};
+
+// Gathers the queued spans, joining adjacent ones, and writes up to IOV_MAX of them per writev()
+class VectoredWriter final : public LineWriter {
+public:
+	VectoredWriter(int fd, bool owned)
+		: file(fd, owned)
+	{
+	}
+
+	void add(std::string_view text) override
+	{
+		if (text.empty()) {
+			return;
+		}
+		if (!pending.empty()) {
+			iovec &last = pending.back();
+			if (static_cast<char const *>(last.iov_base) + last.iov_len == text.data()) {
+				last.iov_len += text.size();
+				return;
+			}
+		}
+		pending.push_back({const_cast<char *>(text.data()), text.size()});
+	}
+
+	bool flush() override
+	{
+		ScopedStageTimer timer(StatsStage::Write);
+		size_t first = 0;
+		while (!failed && first < pending.size()) {
+			int const count = static_cast<int>(std::min<size_t>(pending.size() - first, IOV_MAX));
+			ssize_t const written = ::writev(file.descriptor(), &pending[first], count);
+			if (written < 0) {
+				failed = errno != EINTR;
+				continue;
+			}
+			// A short write leaves the rest of a span, and the spans after it, for the next call
+			auto left = static_cast<size_t>(written);
+			while (left != 0 && left >= pending[first].iov_len) {
+				left -= pending[first].iov_len;
+				++first;
+			}
+			if (left != 0) {
+				pending[first].iov_base = static_cast<char *>(pending[first].iov_base) + left;
+				pending[first].iov_len -= left;
+			}
+		}
+		pending.clear();
+		return !failed;
+	}
+
+	bool finish() override
+	{
+		return flush() && file.close();
+	}
+
+private:
+	OutputFile file;
+	std::vector<iovec> pending;
+	bool failed = false;
+};
+
+// Cuts the queued text into BGZF blocks, each compressed from the pieces it is made of as soon as it is full. A
+// flush waits for the blocks and writes them in order; the start of a block still being filled is then copied, as
+// the memory its pieces are in may be reused.
+class BgzfLineWriter final : public LineWriter {
+public:
+	static constexpr int level = 6;
+
+	BgzfLineWriter(int fd, bool owned, ThreadPool &pool)
+		: file(fd, owned)
+		, pool(pool)
+	{
+		carry.reserve(bgzfBlockInputSize);
+		blocks.push_back(std::make_unique<Block>());
+	}
+	~BgzfLineWriter() override
+	{
+		wait();
+	}
+
+	void add(std::string_view text) override
+	{
+		while (!text.empty()) {
+			size_t const take = std::min(bgzfBlockInputSize - filling, text.size());
+			blocks[submitted]->pieces.push_back(text.substr(0, take));
+			filling += take;
+			text.remove_prefix(take);
+			if (filling == bgzfBlockInputSize) {
+				submit();
+			}
+		}
+	}
+
+	bool flush() override
+	{
+		wait();
+		for (size_t i = 0; i < submitted; ++i) {
+			Block &block = *blocks[i];
+			failed = failed || block.failed
+				|| !writeAll(file.descriptor(), block.compressed.data(), block.compressed.size());
+			block.pieces.clear();
+		}
+		std::swap(blocks[0], blocks[submitted]);
+		submitted = 0;
+
+		// carry has room for a whole block, so appending to it leaves a first piece in it where it is
+		std::vector<std::string_view> &pieces = blocks[0]->pieces;
+		size_t const kept = !pieces.empty() && pieces.front().data() == carry.data() ? 1 : 0;
+		if (kept == 0) {
+			carry.clear();
+		}
+		for (size_t i = kept; i < pieces.size(); ++i) {
+			carry.append(pieces[i]);
+		}
+		pieces.clear();
+		if (!carry.empty()) {
+			pieces.emplace_back(carry);
+		}
+		return !failed;
+	}
+
+	bool finish() override
+	{
+		if (!flush()) {
+			return false;
+		}
+		if (filling != 0) {
+			submit();
+		}
+		submit(); // The end-of-file block, from no pieces
+		return flush() && file.close();
+	}
+
+private:
+	struct Block {
+		std::vector<std::string_view> pieces;
+		std::string compressed;
+		bool failed = false;
+	};
+
+	void submit()
+	{
+		Block *block = blocks[submitted].get();
+		block->failed = false;
+		{
+			std::lock_guard lock(mutex);
+			++running;
+		}
+		pool.submit([this, block] {
+			try {
+				ScopedStageTimer timer(StatsStage::Write);
+				deflateBgzfBlock(block->pieces, level, block->compressed);
+			} catch (std::runtime_error const &) {
+				block->failed = true;
+			}
+			std::lock_guard lock(mutex);
+			--running;
+			finished.notify_all();
+		});
+		if (++submitted == blocks.size()) {
+			blocks.push_back(std::make_unique<Block>());
+		}
+		filling = 0;
+	}
+
+	void wait()
+	{
+		std::unique_lock lock(mutex);
+		finished.wait(lock, [this] { return running == 0; });
+	}
+
+	OutputFile file;
+	ThreadPool &pool;
+	// blocks[0] up to blocks[submitted] are compressing or compressed, blocks[submitted] is being filled with
+	// filling bytes
+	std::vector<std::unique_ptr<Block>> blocks;
+	size_t submitted = 0;
+	size_t filling = 0;
+	std::string carry;
+	std::mutex mutex;
+	std::condition_variable finished;
+	size_t running = 0;
+	bool failed = false;
+};
+
+} // namespace
+
+std::unique_ptr<LineWriter> openLineWriter(std::string const &path, ThreadPool &pool)
+{
+	int fd = STDOUT_FILENO;
+	bool const owned = path != "-";
+	if (owned) {
+		fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+		if (fd < 0) {
+			diagnostics() << "Failed to create file: " << path << ": " << std::strerror(errno) << '\n';
+			return nullptr;
+		}
+	}
+	if (path.ends_with(".gz")) {
+		return std::make_unique<BgzfLineWriter>(fd, owned, pool);
+	}
+	return std::make_unique<VectoredWriter>(fd, owned);
+}
+
+FilteredOutput::FilteredOutput(std::unique_ptr<LineWriter> passed, std::unique_ptr<LineWriter> rejects)
+	: passed(std::move(passed))
+	, rejects(std::move(rejects))
+{
+}
+
+void FilteredOutput::headerLine(std::string_view line)
+{
+	header.append(line);
+	header.push_back('\n');
+}
+
+bool FilteredOutput::writeHeader()
+{
+	passed->add(header);
+	if (rejects) {
+		rejects->add(header);
+	}
+	return flush();
+}
+
+bool FilteredOutput::block(std::string_view text, uint64_t lines, std::span<uint64_t const> rejectedLines)
+{
+	// Start of line, and of the lines passed since the last rejected one
+	size_t position = 0;
+	size_t passedStart = 0;
+	uint64_t line = 1;
+	for (uint64_t const rejected : rejectedLines) {
+		for (; line < rejected; ++line) {
+			position = text.find('\n', position) + 1;
+		}
+		size_t const newline = text.find('\n', position);
+		size_t const end = newline == std::string_view::npos ? text.size() : newline + 1;
+		passed->add(text.substr(passedStart, position - passedStart));
+		if (rejects) {
+			rejects->add(text.substr(position, end - position));
+		}
+		position = end;
+		passedStart = end;
+		++line;
+	}
+	passed->add(text.substr(passedStart));
+	passedCount += lines - rejectedLines.size();
+	rejectedCount += rejectedLines.size();
+	return flush();
+}
+
+bool FilteredOutput::finish()
+{
+	bool const passedFinished = passed->finish();
+	return (!rejects || rejects->finish()) && passedFinished;
+}
+
+bool FilteredOutput::flush()
+{
+	bool const passedFlushed = passed->flush();
+	return (!rejects || rejects->flush()) && passedFlushed;
+}
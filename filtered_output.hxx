@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+
+class ThreadPool;
+
+// Output of --filter-out and --rejects, written in the order it is added straight from the memory it is in
+class LineWriter {
+public:
+	virtual ~LineWriter() = default;
+
+	// Queues text, which must stay where it is until the next flush()
+	virtual void add(std::string_view text) = 0;
+	// Writes everything queued, false once writing has failed
+	virtual bool flush() = 0;
+	// Flushes and ends the output, false if writing failed
+	virtual bool finish() = 0;
+};
+
+// Creates path, "-" for stdout. The queued text is written with writev(), or for a name ending in .gz as BGZF
+// whose blocks are compressed as tasks on pool. nullptr, with the reason on diagnostics(), if path cannot be created.
+std::unique_ptr<LineWriter> openLineWriter(std::string const &path, ThreadPool &pool);
+
+// --filter-out: the header and the data lines that pass validation go to one writer, and with --rejects the header
+// and the data lines that fail to another. Data lines are written from the blocks they were validated in.
+class FilteredOutput {
+public:
+	// rejects may be null
+	FilteredOutput(std::unique_ptr<LineWriter> passed, std::unique_ptr<LineWriter> rejects);
+
+	// Header lines are kept, copied, until the header section is complete
+	void headerLine(std::string_view line);
+	bool writeHeader();
+	// The lines of a block in input order, lines of them, and the numbers of those that failed counting from 1,
+	// sorted. Returns once text is no longer needed; false if writing failed.
+	bool block(std::string_view text, uint64_t lines, std::span<uint64_t const> rejectedLines);
+	bool finish();
+
+	uint64_t passedLines() const
+	{
+		return passedCount;
+	}
+	uint64_t rejectedLines() const
+	{
+		return rejectedCount;
+	}
+
+private:
+	bool flush();
+
+	std::unique_ptr<LineWriter> passed;
+	std::unique_ptr<LineWriter> rejects;
+	std::string header;
+	uint64_t passedCount = 0;
+	uint64_t rejectedCount = 0;
+};
@@ -0,0 +1,249 @@
+#include "format_checks.hxx"
+
+#include "delimiter_scan.hxx"
+#include "header_model.hxx"
+#include "number_syntax.hxx"
+#include "vcf_validation.hxx"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+
+namespace {
+
+bool isNonEmpty(std::string_view value)
+{
+	return !value.empty();
+}
+
+// Cells are tested in groups without branching on their content; only a group containing a cell outside the fast
+// shape is rescanned with the exact scalar check
+constexpr size_t cellGroupSize = 16;
+
+template<bool (*FastShape)(std::string_view), bool (*Check)(std::string_view)>
+size_t firstInvalidGrouped(std::span<std::string_view const> cells)
+{
+	size_t i = 0;
+	for (; i + cellGroupSize <= cells.size(); i += cellGroupSize) {
+		bool allFast = true;
+		for (size_t k = 0; k < cellGroupSize; ++k) {
+			allFast &= FastShape(cells[i + k]);
+		}
+		if (!allFast) {
+			size_t const invalid = firstInvalidCell<Check>(cells.subspan(i, cellGroupSize));
+			if (invalid != cellGroupSize) {
+				return i + invalid;
+			}
+		}
+	}
+	size_t const invalid = firstInvalidCell<Check>(cells.subspan(i));
+	return i + invalid;
+}
+
+constexpr bool isAsciiDigit(unsigned char c)
+{
+	return static_cast<unsigned char>(c - '0') < 10;
+}
+
+// "d/d" or "d|d", the diploid call with single digit alleles
+bool isDiploidCall(std::string_view cell)
+{
+	// Point short cells at a dummy so the three loads below never leave the cell
+	char const *p = cell.size() == 3 ? cell.data() : "...";
+	return (cell.size() == 3) & isAsciiDigit(p[0]) & ((p[1] == '/') | (p[1] == '|')) & isAsciiDigit(p[2]);
+}
+
+// One to eight digits, small enough that no range check is needed
+bool isShortDigitRun(std::string_view cell)
+{
+	size_t const size = cell.size();
+	char const *p = size != 0 ? cell.data() : "0";
+	size_t const last = size != 0 ? size - 1 : 0;
+	bool digits = true;
+	for (size_t k = 0; k < 8; ++k) {
+		digits &= isAsciiDigit(p[std::min(k, last)]);
+	}
+	return digits & (size - 1 < 8);
+}
+
+constexpr FormatKeyCheck formatKeyChecks[] = {
+	{"GT", isValidGenotype, firstInvalidGenotype, "Invalid genotype data: "},
+	{"DP", isNonNegativeInteger, firstInvalidNonNegativeInteger, "Invalid data for DP: "},
+	{"GQ", isNonNegativeInteger, firstInvalidNonNegativeInteger, "Invalid data for GQ: "},
+	{"AD", isListOfNonNegativeIntegers, firstInvalidCell<isListOfNonNegativeIntegers>, "Invalid allele depth data: "},
+	{"PL",
+		isListOfNonNegativeIntegers,
+		firstInvalidCell<isListOfNonNegativeIntegers>,
+		"Invalid phred-scaled genotype likelihoods data: "},
+	{"MQ", isNonNegativeInteger, firstInvalidNonNegativeInteger, "Invalid mapping quality data: "},
+	{"SB", isListOfNonNegativeIntegers, firstInvalidCell<isListOfNonNegativeIntegers>, "Invalid strand bias data: "},
+	{"MQ0", isNonNegativeInteger, firstInvalidNonNegativeInteger, "Invalid MQ0 data: "},
+	{"HRun", isNonNegativeInteger, firstInvalidNonNegativeInteger, "Invalid homopolymer run length data: "},
+	{"AF", isFloat, firstInvalidCell<isFloat>, "Invalid allele frequency data: "},
+	{"AC", isNonNegativeInteger, firstInvalidNonNegativeInteger, "Invalid allele count data: "},
+	{"AN", isNonNegativeInteger, firstInvalidNonNegativeInteger, "Invalid total number of alleles data: "},
+	{"BaseQRankSum", isFloat, firstInvalidCell<isFloat>, "Invalid Base Quality Rank Sum Test data: "},
+	{"ReadPosRankSum", isFloat, firstInvalidCell<isFloat>, "Invalid Read Position Rank Sum Test data: "},
+	{"FS", isFloat, firstInvalidCell<isFloat>, "Invalid Fisher Strand Bias data: "},
+	{"SOR", isFloat, firstInvalidCell<isFloat>, "Invalid Strand Odds Ratio data: "},
+	{"MQRankSum", isFloat, firstInvalidCell<isFloat>, "Invalid Mapping Quality Rank Sum Test data: "},
+	{"QD", isFloat, firstInvalidCell<isFloat>, "Invalid Quality by Depth data: "},
+	{"RPA",
+		isListOfNonNegativeIntegers,
+		firstInvalidCell<isListOfNonNegativeIntegers>,
+		"Invalid Repeat unit number data: "},
+	{"RU", isNonEmpty, firstInvalidCell<isNonEmpty>, "Invalid Repeat unit data: "},
+	{"STR", isBoolean, firstInvalidCell<isBoolean>, "Invalid Short Tandem Repeat data: "},
+	// Additional checks for other descriptors can be added here
+};
+
+} // namespace
+
+size_t firstInvalidGenotype(std::span<std::string_view const> cells)
+{
+	return firstInvalidGrouped<isDiploidCall, isValidGenotype>(cells);
+}
+
+size_t firstInvalidNonNegativeInteger(std::span<std::string_view const> cells)
+{
+	return firstInvalidGrouped<isShortDigitRun, isNonNegativeInteger>(cells);
+}
+
+namespace {
+
+template<typename T>
+bool parsesAs(std::string_view item)
+{
+	T number {};
+	auto const [ptr, ec] = std::from_chars(item.data(), item.data() + item.size(), number);
+	return ec == std::errc() && ptr == item.data() + item.size();
+}
+
+} // namespace
+
+bool isIntegerValues(std::string_view value)
+{
+	return forEachField<','>(value, [](std::string_view item) {
+		return number_syntax::isShortDecimal<false>(item) || item == "." || parsesAs<int>(item);
+	});
+}
+
+bool isFloatValues(std::string_view value)
+{
+	return forEachField<','>(value, [](std::string_view item) {
+		return number_syntax::isShortDecimal<true>(item) || item == "." || parsesAs<float>(item);
+	});
+}
+
+bool isCharacterValues(std::string_view value)
+{
+	return forEachField<','>(value, [](std::string_view item) { return item.size() == 1; });
+}
+
+FormatKeyCheck const *findFormatKeyCheck(std::string_view key)
+{
+	auto const found = std::ranges::find(formatKeyChecks, key, &FormatKeyCheck::key);
+	return found != std::end(formatKeyChecks) ? found : nullptr;
+}
+
+namespace {
+
+// Values of a cell, counted by their separators in one branch-free pass over cells only a few bytes long
+uint64_t valueCount(std::string_view cell)
+{
+	uint64_t separators = 0;
+	for (char const c : cell) {
+		separators += c == ',';
+	}
+	return separators + 1;
+}
+
+uint32_t ploidyOf(std::string_view genotype)
+{
+	uint32_t separators = 0;
+	for (char const c : genotype) {
+		separators += (c == '/') | (c == '|');
+	}
+	return separators + 1;
+}
+
+} // namespace
+
+size_t firstMiscountedCell(std::span<std::string_view const> cells, ValueCount number, uint32_t altAlleles,
+	std::span<std::string_view const> genotypes)
+{
+	uint64_t const expected = expectedValueCount(number, altAlleles);
+	if (number.kind != ValueCount::Kind::PerGenotype) {
+		for (size_t i = 0; i < cells.size(); ++i) {
+			if (valueCount(cells[i]) != expected && cells[i] != ".") {
+				return i;
+			}
+		}
+		return cells.size();
+	}
+
+	uint64_t const haploid = expectedValueCount(number, altAlleles, 1);
+	for (size_t i = 0; i < cells.size(); ++i) {
+		uint64_t const values = valueCount(cells[i]);
+		if (values == expected && genotypes.empty()) {
+			continue;
+		}
+		std::string_view const genotype = i < genotypes.size() ? genotypes[i] : ".";
+		bool const matches = genotype == "." ? values == expected || values == haploid
+											 : values == expectedValueCount(number, altAlleles, ploidyOf(genotype));
+		if (!matches && cells[i] != ".") {
+			return i;
+		}
+	}
+	return cells.size();
+}
+
+ResolvedFormat const &FormatDispatchCache::resolve(std::string_view format, HeaderModel const *header)
+{
+	uint64_t const generation = header != nullptr ? header->generation() : 0;
+	if (generation != headerGeneration) {
+		headerGeneration = generation;
+		used = 0;
+		nextVictim = 0;
+	}
+	for (size_t i = 0; i < used; ++i) {
+		if (entries[i].format == format) {
+			return entries[i].resolved;
+		}
+	}
+
+	// Replace the oldest entry; the strings and vectors keep their capacity
+	Entry &entry = entries[nextVictim];
+	nextVictim = (nextVictim + 1) % entries.size();
+	used = std::max(used, nextVictim == 0 ? entries.size() : nextVictim);
+
+	entry.format.assign(format);
+	ResolvedFormat &resolved = entry.resolved;
+	resolved.checks.clear();
+	resolved.numbers.clear();
+	resolved.genotypeKey = ResolvedFormat::npos;
+	forEachField<':'>(format, [&resolved, header](std::string_view key) {
+		FormatKeyCheck const *check = findFormatKeyCheck(key);
+		ValueCount number;
+		if (header != nullptr) {
+			if (check == nullptr) {
+				check = header->declaredFormatCheck(key);
+			}
+			FieldDefinition const *declared = header->findFormat(key);
+			if (declared != nullptr && declared->number.kind != ValueCount::Kind::Fixed) {
+				number = declared->number;
+			}
+			if (check == nullptr && number.kind != ValueCount::Kind::Unknown) {
+				// A String key still has its values counted, reported with the declaration's message
+				check = header->declaredFormatKey(key);
+			}
+		}
+		if (key == "GT" && resolved.genotypeKey == ResolvedFormat::npos) {
+			resolved.genotypeKey = resolved.checks.size();
+		}
+		resolved.checks.push_back(check);
+		resolved.numbers.push_back(number);
+		return true;
+	});
+	return resolved;
+}
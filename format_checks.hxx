@@ -0,0 +1,91 @@
+#pragma once
+
+#include "value_count.hxx"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class HeaderModel;
+
+// Validator for one FORMAT key, the message is printed in front of the offending sample value
+struct FormatKeyCheck {
+	std::string_view key;
+	bool (*check)(std::string_view value);
+	// Checks the key's cells of every sample in a record at once, returns the index of the first invalid cell or
+	// cells.size()
+	size_t (*checkColumn)(std::span<std::string_view const> cells);
+	std::string_view message;
+};
+
+// Column check that applies Check cell by cell
+template<bool (*Check)(std::string_view)>
+size_t firstInvalidCell(std::span<std::string_view const> cells)
+{
+	for (size_t i = 0; i < cells.size(); ++i) {
+		if (!Check(cells[i])) {
+			return i;
+		}
+	}
+	return cells.size();
+}
+
+// Column checks for the most common cell shapes, see format_checks.cxx
+size_t firstInvalidGenotype(std::span<std::string_view const> cells);
+size_t firstInvalidNonNegativeInteger(std::span<std::string_view const> cells);
+
+// Comma-separated lists of one ##INFO or ##FORMAT Type, '.' for missing values; used for INFO entries and for
+// FORMAT keys the header declares but the table of built-in checks does not cover
+bool isIntegerValues(std::string_view value);
+bool isFloatValues(std::string_view value);
+bool isCharacterValues(std::string_view value);
+
+// The check for a FORMAT key, nullptr for keys that are not validated
+FormatKeyCheck const *findFormatKeyCheck(std::string_view key);
+
+// Index of the first cell whose value count is not what number gives for a record with altAlleles ALT alleles, or
+// cells.size(). Values are counted by their separators, a '.' cell is a missing value. For Number=G the ploidy of
+// each sample is that of its cell in genotypes, the samples' GT cells; without them, or where GT is missing, haploid
+// and diploid counts are both accepted.
+size_t firstMiscountedCell(std::span<std::string_view const> cells, ValueCount number, uint32_t altAlleles,
+	std::span<std::string_view const> genotypes = {});
+
+// The FORMAT column of a record resolved against a header
+struct ResolvedFormat {
+	// One entry per key, in column order; nullptr entries need no check, entries without a checkColumn only a count
+	// check of their values
+	std::vector<FormatKeyCheck const *> checks;
+	// Number= of each key the header declares Number=A, R or G, whose value count depends on the record's alleles;
+	// Unknown for every other key
+	std::vector<ValueCount> numbers;
+	// Index of the GT key, npos without one
+	size_t genotypeKey = npos;
+
+	static constexpr size_t npos = static_cast<size_t>(-1);
+};
+
+// Resolves FORMAT columns to one check per key, remembering the most recently seen distinct FORMAT strings so
+// records sharing a FORMAT column skip the key lookups entirely
+class FormatDispatchCache {
+public:
+	// Keys without a built-in check get the one header derives from their declared Type. The result stays valid
+	// until the next call.
+	ResolvedFormat const &resolve(std::string_view format, HeaderModel const *header = nullptr);
+
+private:
+	struct Entry {
+		std::string format;
+		ResolvedFormat resolved;
+	};
+
+	std::array<Entry, 8> entries;
+	size_t nextVictim = 0;
+	size_t used = 0;
+	// The entries were resolved against the header of this HeaderModel::generation(), 0 for none. A model built or
+	// reset at the address of an earlier one has a generation of its own, so its address would not do.
+	uint64_t headerGeneration = 0;
+};
@@ -1,570 +1,1043 @@
+#include "allocation_counter.hxx"
+#include "batch_validator.hxx"
+#include "bgzf_reader.hxx"
+#include "block_reader.hxx"
+#include "checkpoint.hxx"
+#include "content_hash.hxx"
+#include "decompressor.hxx"
+#include "error_sink.hxx"
+#include "filtered_output.hxx"
+#include "header_model.hxx"
+#include "mapped_file.hxx"
+#include "parallel_validator.hxx"
+#include "pipelined_input.hxx"
+#include "read_ahead.hxx"
+#include "record_order.hxx"
+#include "region_validator.hxx"
+#include "result_cache.hxx"
+#include "tabix_index.hxx"
+#include "thread_affinity.hxx"
+#include "thread_pool.hxx"
+#include "validation_options.hxx"
+#include "validation_server.hxx"
+#include "validation_stats.hxx"
+#include "vcf_validation.hxx"
+
 #include <algorithm>
 #include <charconv>
+#include <cstdint>
 #include <cstdlib>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
-#include <regex>
+#include <optional>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <utility>
 #include <vector>
 
-#include <boost/iostreams/copy.hpp>
-#include <boost/iostreams/filter/gzip.hpp>
-#include <boost/iostreams/filtering_streambuf.hpp>
-
 // Function prototypes
-bool validateFormat(std::string const &fileName);
-bool validateHeaderLine(std::string_view line);
-bool checkDataLines(std::string_view line);
+// Validates one file, printing why it is invalid to diagnostics(). With pool, that pool is used instead of one
+// of options.threads workers.
+bool validateFormat(std::string const &fileName, ValidationOptions const &options, ThreadPool *pool = nullptr);
 
-int main(int argc, char *argv[])
+static void printUsage(char const *program)
 {
-	if (argc != 2) {
-		std::cerr << "Usage: " << argv[0] << " <VCF filename>\n";
-		return EXIT_FAILURE;
-	}
-
-	std::string fileName = argv[1];
-	if (!validateFormat(fileName)) {
-		std::cerr << "Invalid VCF file format.\n";
-		return EXIT_FAILURE;
-	}
+	std::cerr << "Usage: " << program << " [--threads N] [--max-errors N] [--region R]... [--regions-file FILE] [--parallel-contigs]\n"
+			  << "       [--profile NAME] [--samples LIST] [--sample-rate R] [--sites-only]\n"
+			  << "       [--read-ahead N] [--read-block-size N] [--read-threads] [--inflate-ahead N]\n"
+			  << "       [--inflate-backend NAME] [--checkpoint N] [--resume] [--cache DIR] [--cache-verify]\n"
+			  << "       [--no-cache] [--affinity SPEC] [--filter-out FILE] [--rejects FILE] [--stats]\n"
+			  << "       [--stats-json FILE] [--batch LIST] <VCF filename>...\n"
+			  << "       " << program << " --serve SOCKET [options]\n"
+			  << "  --threads N          validate data lines on N worker threads (0 = one per core)\n"
+			  << "  --affinity SPEC      place threads: [STAGE=]PLACE items separated by ':', STAGE main, reader,\n"
+			  << "                       inflate or workers (default), PLACE compact or spread (workers over the NUMA\n"
+			  << "                       nodes), nodeN or a CPU list such as 0-7,16-23; e.g. spread:reader=node0\n"
+			  << "  --max-errors N       report up to N invalid lines with their locations instead of stopping at the\n"
+			  << "                       first one (0 = no limit)\n"
+			  << "  --region R           only validate data lines overlapping chr, chr:start or chr:start-end (1-based),\n"
+			  << "                       read through the file's .tbi or .csi index; may be repeated\n"
+			  << "  --regions-file FILE  regions one per line as chr:start-end or chr<TAB>start<TAB>end (BED if .bed)\n"
+			  << "  --parallel-contigs   validate every contig of the index, or every region, as its own task\n"
+			  << "  --profile NAME       checks of data lines: strict (default), structural (columns, positions, order\n"
+			  << "                       and alleles only), human-GRCh38 (strict plus GRCh38 chromosome lengths) or\n"
+			  << "                       non-human (strict without the human chromosome names)\n"
+			  << "  --samples LIST       check the sample columns of only these samples, comma-separated\n"
+			  << "  --sample-rate R      check the samples of a fraction R of the records, picked by CHROM and POS\n"
+			  << "  --sites-only         check neither FORMAT nor the sample columns\n"
+			  << "  --read-ahead N       keep N reads of compressed input in flight ahead of decompression (default 4,\n"
+			  << "                       0 = plain synchronous reads)\n"
+			  << "  --read-block-size N  bytes per read (default 1 MiB)\n"
+			  << "  --read-threads       issue them from a thread pool even where io_uring is available\n"
+			  << "  --inflate-ahead N    inflate plain gzip, and BGZF without --threads, on a thread of its own up to N\n"
+			  << "                       MiB ahead of validation (default 4, 0 = on the validating thread)\n"
+			  << "  --inflate-backend NAME\n"
+			  << "                       inflate BGZF blocks with libdeflate (where built in) or zlib rather than the\n"
+			  << "                       backend that inflates a sample block fastest on this host\n"
+			  << "  --checkpoint N       record how far the file is valid in FILE.vcfcheck every N BGZF blocks (64 KiB\n"
+			  << "                       pieces if uncompressed) and continue from there when run again, so after the\n"
+			  << "                       file has records appended only the new ones are validated; validates serially\n"
+			  << "  --resume             continue from FILE.vcfcheck, checkpointing every 1024 blocks unless --checkpoint\n"
+			  << "  --cache DIR          reuse the results of files validated before with the same validator build,\n"
+			  << "                       checks and --max-errors if they are unchanged since, and store new ones in\n"
+			  << "                       DIR (default $GENOMIC_VALIDATOR_CACHE, if set)\n"
+			  << "  --cache-verify       compare the content hash of the file rather than its size and mtime\n"
+			  << "  --no-cache           neither read nor write the cache\n"
+			  << "  --filter-out FILE    write the header and the data lines that pass to FILE (- for stdout, BGZF if\n"
+			  << "                       it ends in .gz), validating the whole file and reporting up to --max-errors\n"
+			  << "                       invalid lines\n"
+			  << "  --rejects FILE       also write the header and the data lines that fail to FILE\n"
+			  << "  --stats              print bytes, records, samples and time and heap allocations per stage to stderr\n"
+			  << "  --stats-json FILE    also write the --stats report as JSON to FILE\n"
+			  << "  --batch LIST         also validate the files listed in LIST, one per line; with several files all of\n"
+			  << "                       them share one pool (--threads, default one per core) and a summary table of\n"
+			  << "                       the results is printed\n"
+			  << "  --serve SOCKET       validate the files named by, or sent over, connections to the Unix socket\n"
+			  << "                       SOCKET until interrupted, answering each request with JSON (see\n"
+			  << "                       validation_server.hxx); serves --threads connections at a time, by default\n"
+			  << "                       one per core\n";
+}
 
-	std::cout << "VCF file is valid.\n";
-	return EXIT_SUCCESS;
+template<typename T>
+static bool parseNumber(std::string_view text, T &value)
+{
+	auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+	return ec == std::errc() && ptr == text.data() + text.size();
 }
 
-bool isValidAlt(std::string_view alt)
+// --batch and several file arguments: one pool for all of the files, a summary table on stdout and the messages
+// of the invalid files, each line prefixed with the file name, on stderr
+static bool validateFiles(
+	std::vector<std::string> const &fileNames, ValidationOptions const &options, bool threadsGiven)
 {
-	// Regular expression to match valid ALT alleles: bases, '*', or symbolic alleles (angle brackets not covered here)
-	static std::regex const altRegex("^([ACGTN*]+|<[^>]+>)(,[ACGTN*]+|,<[^>]+>)*$");
-	return std::regex_match(alt.cbegin(), alt.cend(), altRegex);
+	ThreadPool pool(threadsGiven ? options.threads : std::max(1u, std::thread::hardware_concurrency()));
+	// Files of a few blocks or more are worth splitting across the pool, if it has more than one worker
+	uint64_t const largeFileSize = pool.size() > 1 ? uint64_t {4} * options.blockSize : UINT64_MAX;
+	ValidationOptions serial = options;
+	serial.threads = 1;
+	auto const results
+		= validateBatch(fileNames, pool, largeFileSize, [&](std::string const &fileName, ThreadPool *filePool) {
+			  return validateFormat(fileName, filePool != nullptr ? options : serial, filePool);
+		  });
+
+	printBatchSummary(std::cout, fileNames, results);
+	size_t invalid = 0;
+	for (size_t i = 0; i < results.size(); ++i) {
+		if (results[i].valid) {
+			continue;
+		}
+		++invalid;
+		std::string_view messages = results[i].messages;
+		while (!messages.empty()) {
+			size_t const newline = std::min(messages.find('\n'), messages.size());
+			std::cerr << fileNames[i] << ": " << messages.substr(0, newline) << '\n';
+			messages.remove_prefix(std::min(newline + 1, messages.size()));
+		}
+	}
+	if (invalid != 0) {
+		std::cerr << invalid << " of " << results.size() << " VCF files are invalid.\n";
+	}
+	return invalid == 0;
 }
 
-bool validateFormat(std::string const &fileName)
+// --serve: like several files in one process, each validated whole on its connection's thread unless it is large
+static bool serveFiles(std::string const &socketPath, ValidationOptions const &options, bool threadsGiven)
 {
-	std::ifstream file(fileName, std::ios_base::in | std::ios_base::binary);
-	if (!file.is_open()) {
-		std::cerr << "Failed to open file: " << fileName << '\n';
-		return false;
+	ValidationOptions serving = options;
+	if (!threadsGiven) {
+		serving.threads = std::max(1u, std::thread::hardware_concurrency());
 	}
+	ValidationOptions serial = options;
+	serial.threads = 1;
+	return serveValidation(socketPath, serving, [&](std::string const &fileName, ThreadPool *filePool) {
+		return validateFormat(fileName, filePool != nullptr ? serving : serial, filePool);
+	});
+}
 
-	boost::iostreams::filtering_streambuf<boost::iostreams::input> in;
-	if (!fileName.ends_with(".vcf")) {
-		in.push(boost::iostreams::gzip_decompressor());
+// Prints the --stats report once validation has finished and its threads are joined
+static bool reportStats(ValidationOptions const &options)
+{
+	StatsReport const report = collectStats();
+	printStats(std::cerr, report);
+	if (options.statsJsonFile.empty()) {
+		return true;
+	}
+	std::ofstream json(options.statsJsonFile);
+	printStatsJson(json, report);
+	if (!json.flush()) {
+		std::cerr << "Failed to write file: " << options.statsJsonFile << '\n';
+		return false;
 	}
-	in.push(file);
+	return true;
+}
 
-	std::istream inf(&in);
-	std::string line;
-	bool headerLineFound = false;
-	while (std::getline(inf, line)) {
-		if (line.starts_with("##")) { // Meta-information lines
-			if (!validateHeaderLine(line)) {
-				return false;
+int main(int argc, char *argv[])
+{
+	ValidationOptions options;
+	std::vector<std::string> fileNames;
+	std::vector<std::string> batchLists;
+	bool threadsGiven = false;
+	bool noCache = false;
+	std::string serveSocket;
+	AffinityPlan affinity;
+	for (int i = 1; i < argc; ++i) {
+		std::string_view const arg = argv[i];
+		if (arg == "--threads" && i + 1 < argc) {
+			if (!parseNumber(argv[++i], options.threads)) {
+				printUsage(argv[0]);
+				return EXIT_FAILURE;
 			}
-		} else if (line.starts_with("#") && !headerLineFound) { // Column header line
-			headerLineFound = true;
-			// Optional: Validate the content of the header line
-			// if (!validateHeaderColumns(line)) return false;
-		} else if (headerLineFound) { // Data lines
-			// Process data lines
-			if (!checkDataLines(line)) {
-				return false;
+			threadsGiven = true;
+			if (options.threads == 0) {
+				options.threads = std::max(1u, std::thread::hardware_concurrency());
+			}
+		} else if (arg == "--affinity" && i + 1 < argc) {
+			if (!parseAffinity(argv[++i], affinity)) {
+				printUsage(argv[0]);
+				return EXIT_FAILURE;
+			}
+		} else if (arg == "--max-errors" && i + 1 < argc) {
+			if (!parseNumber(argv[++i], options.maxErrors)) {
+				printUsage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			if (options.maxErrors == 0) {
+				options.maxErrors = SIZE_MAX;
+			}
+		} else if (arg == "--region" && i + 1 < argc) {
+			options.regions.emplace_back(argv[++i]);
+		} else if (arg == "--regions-file" && i + 1 < argc) {
+			options.regionsFile = argv[++i];
+		} else if (arg == "--parallel-contigs") {
+			options.parallelContigs = true;
+		} else if (arg == "--stats") {
+			options.stats = true;
+		} else if (arg == "--stats-json" && i + 1 < argc) {
+			options.stats = true;
+			options.statsJsonFile = argv[++i];
+		} else if (arg == "--profile" && i + 1 < argc) {
+			if (!parseProfile(argv[++i], options.profile)) {
+				printUsage(argv[0]);
+				return EXIT_FAILURE;
+			}
+		} else if (arg == "--samples" && i + 1 < argc) {
+			std::string_view names = argv[++i];
+			while (!names.empty()) {
+				size_t const comma = std::min(names.find(','), names.size());
+				if (comma != 0) {
+					options.samples.names.emplace_back(names.substr(0, comma));
+				}
+				names.remove_prefix(std::min(comma + 1, names.size()));
+			}
+		} else if (arg == "--sample-rate" && i + 1 < argc) {
+			double &rate = options.samples.rate;
+			if (!parseNumber(argv[++i], rate) || !(rate >= 0 && rate <= 1)) {
+				printUsage(argv[0]);
+				return EXIT_FAILURE;
 			}
+		} else if (arg == "--sites-only") {
+			options.samples.sitesOnly = true;
+		} else if (arg == "--read-ahead" && i + 1 < argc) {
+			if (!parseNumber(argv[++i], options.readAheadDepth)) {
+				printUsage(argv[0]);
+				return EXIT_FAILURE;
+			}
+		} else if (arg == "--read-block-size" && i + 1 < argc) {
+			if (!parseNumber(argv[++i], options.readBlockSize) || options.readBlockSize == 0) {
+				printUsage(argv[0]);
+				return EXIT_FAILURE;
+			}
+		} else if (arg == "--read-threads") {
+			options.readAheadThreads = true;
+		} else if (arg == "--inflate-ahead" && i + 1 < argc) {
+			if (!parseNumber(argv[++i], options.inflateAheadDepth)) {
+				printUsage(argv[0]);
+				return EXIT_FAILURE;
+			}
+		} else if (arg == "--inflate-backend" && i + 1 < argc) {
+			if (!selectInflateBackend(argv[++i])) {
+				printUsage(argv[0]);
+				return EXIT_FAILURE;
+			}
+		} else if (arg == "--checkpoint" && i + 1 < argc) {
+			if (!parseNumber(argv[++i], options.checkpointBlocks) || options.checkpointBlocks == 0) {
+				printUsage(argv[0]);
+				return EXIT_FAILURE;
+			}
+		} else if (arg == "--resume") {
+			if (options.checkpointBlocks == 0) {
+				options.checkpointBlocks = ValidationOptions::defaultCheckpointBlocks;
+			}
+		} else if (arg == "--cache" && i + 1 < argc) {
+			options.cacheDirectory = argv[++i];
+		} else if (arg == "--cache-verify") {
+			options.cacheVerify = true;
+		} else if (arg == "--no-cache") {
+			noCache = true;
+		} else if (arg == "--filter-out" && i + 1 < argc) {
+			options.filterOutput = argv[++i];
+		} else if (arg == "--rejects" && i + 1 < argc) {
+			options.rejectsOutput = argv[++i];
+		} else if (arg == "--serve" && i + 1 < argc) {
+			serveSocket = argv[++i];
+		} else if (arg == "--batch" && i + 1 < argc) {
+			batchLists.emplace_back(argv[++i]);
+		} else if (!arg.starts_with("--")) {
+			fileNames.emplace_back(arg);
 		} else {
-			std::cerr << "Unexpected line format: " << line << '\n';
-			return false;
+			printUsage(argv[0]);
+			return EXIT_FAILURE;
 		}
 	}
+	if (noCache) {
+		options.cacheDirectory.clear();
+	} else if (char const *cache = std::getenv("GENOMIC_VALIDATOR_CACHE"); options.cacheDirectory.empty() && cache) {
+		options.cacheDirectory = cache;
+	}
+	// Before any thread of validation starts
+	setAffinity(std::move(affinity));
 
-	if (!headerLineFound) {
-		std::cerr << "Missing column header line.\n";
-		return false;
+	if (!serveSocket.empty()) {
+		if (!fileNames.empty() || !batchLists.empty() || !options.filterOutput.empty()) {
+			printUsage(argv[0]);
+			return EXIT_FAILURE;
+		}
+		return serveFiles(serveSocket, options, threadsGiven) ? EXIT_SUCCESS : EXIT_FAILURE;
 	}
 
-	return true;
-}
+	bool const batch = !batchLists.empty() || fileNames.size() > 1;
+	for (auto const &list : batchLists) {
+		if (!readBatchList(list, fileNames)) {
+			return EXIT_FAILURE;
+		}
+	}
+	if (fileNames.empty()) {
+		printUsage(argv[0]);
+		return EXIT_FAILURE;
+	}
+	// Filtering writes the whole of one file in order
+	bool const filtering = !options.filterOutput.empty();
+	if (filtering
+		&& (batch || !options.regions.empty() || !options.regionsFile.empty() || options.parallelContigs
+			|| options.checkpointBlocks != 0)) {
+		std::cerr << "--filter-out takes one file without --batch, --region, --regions-file, --parallel-contigs or "
+					 "--checkpoint\n";
+		return EXIT_FAILURE;
+	}
+	if (!filtering && !options.rejectsOutput.empty()) {
+		printUsage(argv[0]);
+		return EXIT_FAILURE;
+	}
 
-bool validateFileFormatLine(std::string_view line)
-{
-	static std::regex const fileFormatRegex("##fileformat=VCFv(\\d+\\.\\d+)");
-	if (!std::regex_match(line.cbegin(), line.cend(), fileFormatRegex)) {
-		std::cerr << "Invalid file format version: " << line << '\n';
-		return false;
+	if (options.stats) {
+		countAllocationsWith(threadHeapAllocations);
+		enableStats();
+	}
+	bool const valid
+		= batch ? validateFiles(fileNames, options, threadsGiven) : validateFormat(fileNames.front(), options);
+	if (options.stats && !reportStats(options)) {
+		return EXIT_FAILURE;
+	}
+	if (batch) {
+		return valid ? EXIT_SUCCESS : EXIT_FAILURE;
 	}
-	return true;
-}
 
-bool validateContigLine(std::string_view line)
-{
-	static std::regex const contigRegex("##contig=<ID=[^,]+(,length=\\d+)?(,.*)?>");
-	if (!std::regex_match(line.cbegin(), line.cend(), contigRegex)) {
-		std::cerr << "Invalid contig line: " << line << '\n';
-		return false;
+	if (!valid) {
+		std::cerr << "Invalid VCF file format.\n";
+		return EXIT_FAILURE;
 	}
-	return true;
+
+	// Not into the filtered output
+	(options.filterOutput == "-" ? std::cerr : std::cout) << "VCF file is valid.\n";
+	return EXIT_SUCCESS;
 }
 
-bool validateAltLine(std::string_view line)
+namespace {
+
+enum class HeaderResult
 {
-	static std::regex const altRegex("##ALT=<ID=[^,]+,Description=\"[^\"]+\">");
-	if (!std::regex_match(line.cbegin(), line.cend(), altRegex)) {
-		std::cerr << "Invalid ALT line: " << line << '\n';
-		return false;
+	Complete,
+	Invalid,
+	Missing
+};
+
+// Validates the meta-information lines up to and including the column header line and builds header from them,
+// lineNumber counts the lines read. Invalid lines go to collector, which decides whether to carry on.
+template<typename NextLine>
+HeaderResult validateHeaderSection(
+	NextLine &&nextLine, ErrorCollector &collector, uint64_t &lineNumber, HeaderModel &header)
+{
+	ErrorSinkScope scope(collector.sink());
+	std::string_view line;
+	while (nextLine(line)) {
+		collector.sink().setLine(++lineNumber);
+		bool valid = true;
+		if (line.starts_with("##")) { // Meta-information lines
+			valid = validateHeaderLine(line, &header);
+		} else if (line.starts_with("#")) { // Column header line
+			if (!checkTitleLine(line, &header) && !collector.lineFailed()) {
+				return HeaderResult::Invalid;
+			}
+			return HeaderResult::Complete;
+		} else {
+			reportError(ErrorCode::UnexpectedLine, line);
+			valid = false;
+		}
+		if (!valid && !collector.lineFailed()) {
+			return HeaderResult::Invalid;
+		}
 	}
-	return true;
+	return HeaderResult::Missing;
 }
 
-bool validateSampleOrPedigreeLine(std::string_view line)
+// Prints why the header section ended early, true if it is complete
+bool headerComplete(HeaderResult result, ErrorCollector &collector, bool readFailed, std::string_view fileName = {})
 {
-	// Basic structure check; can be more specific based on VCF version and use case
-	if (line.starts_with("##SAMPLE=") || line.starts_with("##PEDIGREE=")) {
-		return true; // Assuming well-formed for this example
+	switch (result) {
+	case HeaderResult::Complete:
+		return true;
+	case HeaderResult::Missing:
+		collector.flush();
+		if (readFailed) {
+			diagnostics() << "Failed to read or decompress file: " << fileName << '\n';
+		} else {
+			diagnostics() << "Missing column header line.\n";
+		}
+		[[fallthrough]];
+	case HeaderResult::Invalid:
+		break;
 	}
-	std::cerr << "Invalid SAMPLE or PEDIGREE line: " << line << '\n';
 	return false;
 }
 
-bool validateHeaderLine(std::string_view line)
+// Lines from a decompressing stream, read into buffer
+auto streamLines(std::istream &inf, std::string &buffer)
 {
-	static std::regex const infoFormatRegex(
-		"##(INFO|FORMAT)=<"
-		"ID=[^,]+,"
-		"Number=([\\.\\dAGRU]|-?\\d+),"
-		"Type=(Integer|Float|Flag|Character|String),"
-		"Description=\"[^\"]+\""
-		"(,[^,]+=\"[^\"]+\")*>");
-	static std::regex const filterRegex(
-		"##FILTER=<"
-		"ID=[^,]+,"
-		"Description=\"[^\"]+\""
-		">");
-
-	if (line.starts_with("##INFO=") || line.starts_with("##FORMAT=")) {
-		if (!std::regex_match(line.cbegin(), line.cend(), infoFormatRegex)) {
-			std::cerr << "Invalid INFO or FORMAT line: " << line << '\n';
+	return [&inf, &buffer](std::string_view &line) {
+		ScopedStageTimer timer(StatsStage::Read);
+		if (!std::getline(inf, buffer)) {
 			return false;
 		}
+		line = buffer;
+		countStats(StatsCounter::Bytes, buffer.size() + 1);
 		return true;
-	} else if (line.starts_with("##FILTER=")) {
-		if (!std::regex_match(line.cbegin(), line.cend(), filterRegex)) {
-			std::cerr << "Invalid FILTER line: " << line << '\n';
-			return false;
-		}
-		return true;
-	} else if (line.starts_with("##fileformat=")) {
-		return validateFileFormatLine(line);
-	} else if (line.starts_with("##contig=")) {
-		return validateContigLine(line);
-	} else if (line.starts_with("##ALT=")) {
-		return validateAltLine(line);
-	} else if (line.starts_with("##SAMPLE=") || line.starts_with("##PEDIGREE=")) {
-		return validateSampleOrPedigreeLine(line);
-	}
-
-	if (line.starts_with("##")) {
-		// Optionally, perform a basic structure check here, if necessary
-		return true; // Accepts any well-formed header lines not covered by specific checks
-	}
-
-	std::cerr << "Unknown header format: " << line << '\n';
-	return false;
+	};
 }
 
-bool checkTitleLine(std::string const &line)
+// The options that decide which checks data lines get, for telling whether an earlier result still applies
+std::string checksDescription(ValidationOptions const &options)
 {
-	std::istringstream iss(line);
-	std::vector<std::string> columns;
-	std::string column;
-
-	while (iss >> column) {
-		columns.push_back(column);
+	std::string description(profileName(options.profile));
+	SampleSelection const &samples = options.samples;
+	if (samples.sitesOnly) {
+		return description + " sites-only";
 	}
-
-	// Check for required columns
-	std::vector<std::string> const requiredColumns = {"#CHROM", "POS", "ID", "REF", "ALT", "QUAL", "FILTER", "INFO"};
-	if (columns.size() < requiredColumns.size()) {
-		std::cerr << "Insufficient columns in title line.\n";
-		return false;
+	for (size_t i = 0; i < samples.names.size(); ++i) {
+		description += (i == 0 ? " samples " : ",") + samples.names[i];
 	}
-
-	return std::equal(columns.begin(), columns.begin() + requiredColumns.size(), requiredColumns.begin());
-}
-
-bool checkHeader(std::string const &line)
-{
-	if (line.starts_with("##fileformat=")) {
-		return validateHeaderLine(line);
-	} else if (line.starts_with("##INFO=") || line.starts_with("##FILTER=") || line.starts_with("##FORMAT=")) {
-		// Add specific checks for each type of meta-information line if necessary
-		return true;
-	} else if (line[0] == '#' && line[1] != '#') { // Title line
-		return checkTitleLine(line);
-	} else {
-		std::cerr << "Unknown header format: " << line << '\n';
-		return false;
+	if (samples.rate < 1) {
+		description += " sample-rate " + std::to_string(samples.rate);
 	}
+	return description;
 }
 
-std::vector<std::string_view> split(std::string_view str, char delimiter)
+template<typename NextLine>
+void validateBodySerial(NextLine &&nextLine, ErrorCollector &collector, uint64_t &lineNumber, HeaderModel const &header,
+	ValidationProfile profile)
 {
-	std::vector<std::string_view> result;
-	size_t start = 0;
-	size_t end = 0;
-
-	while ((end = str.find(delimiter, start)) != std::string_view::npos) {
-		// Add a string_view of the token to the result
-		result.emplace_back(str.substr(start, end - start));
-		start = end + 1; // Move past the delimiter
+	ErrorSinkScope scope(collector.sink());
+	RecordOrder order;
+	std::string_view line;
+	while (nextLine(line)) {
+		collector.sink().setLine(++lineNumber);
+		order.setLine(lineNumber);
+		if (!validateBodyLine(line, &header, &order, profile) && !collector.lineFailed()) {
+			return;
+		}
 	}
-	// Add the last token after the final delimiter
-	result.emplace_back(str.substr(start));
-
-	return result;
 }
 
-bool isValidBase(std::string_view base)
+// Header lines from nextLine, also kept by output if there is one
+template<typename NextLine>
+auto outputHeaderLines(NextLine &nextLine, FilteredOutput *output)
 {
-	for (char c : base) {
-		switch (c) {
-			// clang-format off
-    case 'A': case 'a':
-    case 'C': case 'c':
-    case 'G': case 'g':
-    case 'T': case 't':
-    case 'N': case 'n':
-			// clang-format on
-			continue;
-		default:
+	return [&nextLine, output](std::string_view &line) {
+		if (!nextLine(line)) {
 			return false;
 		}
-	}
-	return true;
+		if (output != nullptr) {
+			output->headerLine(line);
+		}
+		return true;
+	};
 }
 
-bool isValidGenotype(std::string_view gt)
-{
-	if (gt == ".") {
-		return true; // Handle missing data
+// Hands out the blocks of reader, hashing each into contentHash first; the blocks point into contents
+class HashingBlockReader final : public BlockReader {
+public:
+	HashingBlockReader(BlockReader &reader, std::string_view contents, ContentHash &contentHash)
+		: reader(reader)
+		, contents(contents)
+		, contentHash(contentHash)
+	{
 	}
 
-	bool validFormat = true;
-	bool seenDigit = false;
-
-	for (size_t i = 0; i < gt.size(); ++i) {
-		char c = gt[i];
-		if (isdigit(c)) {
-			seenDigit = true;
-			continue;
-		} else if ((c == '/' || c == '|') && i > 0 && i < gt.size() - 1 && seenDigit) {
-			// Ensure separators are surrounded by digits
-			seenDigit = false; // Reset for next digit check
-			continue;
-		} else {
-			validFormat = false;
-			break;
+	bool next(TextBlock &block) override
+	{
+		if (!reader.next(block)) {
+			return false;
 		}
+		contentHash.update(static_cast<uint64_t>(block.text.data() - contents.data()), block.text);
+		return true;
 	}
-	return validFormat && seenDigit; // Ensure ends with a digit
-}
 
-bool isNonNegativeInteger(std::string_view str)
-{
-	int value = 0;
-	auto result = std::from_chars(str.data(), str.data() + str.size(), value);
-	// Successful parse and non-negative check
-	return result.ec == std::errc() && value >= 0;
-}
+private:
+	BlockReader &reader;
+	std::string_view contents;
+	ContentHash &contentHash;
+};
 
-bool isListOfNonNegativeIntegers(std::string_view str)
+// Uncompressed input: lines are views straight into the mapping. With contentHash, what validation reads of it is
+// hashed as it goes, a block at a time while those bytes are still in the CPU caches.
+bool validateMappedFile(MappedFile const &file, ThreadPool *pool, ValidationOptions const &options,
+	ErrorCollector &collector, HeaderModel &header, ContentHash *contentHash, FilteredOutput *output)
 {
-	auto tokens = split(str, ',');
-	for (auto &token : tokens) {
-		if (!isNonNegativeInteger(token)) {
+	std::string_view const contents = file.contents();
+	std::string_view remaining = contents;
+	size_t hashed = 0;
+	auto hashRead = [&](size_t atLeast) {
+		size_t const read = contents.size() - remaining.size();
+		if (contentHash != nullptr && read - hashed >= atLeast) {
+			contentHash->update(hashed, contents.substr(hashed, read - hashed));
+			hashed = read;
+		}
+	};
+	auto nextLine = [&remaining, &hashRead](std::string_view &line) {
+		ScopedStageTimer timer(StatsStage::Read);
+		if (remaining.empty()) {
 			return false;
 		}
+		auto const newline = remaining.find('\n');
+		line = remaining.substr(0, newline);
+		remaining.remove_prefix(newline == std::string_view::npos ? remaining.size() : newline + 1);
+		countStats(StatsCounter::Bytes, line.size() + 1);
+		hashRead(size_t {64} << 10);
+		return true;
+	};
+
+	uint64_t lineNumber = 0;
+	bool const headerValid
+		= headerComplete(validateHeaderSection(outputHeaderLines(nextLine, output), collector, lineNumber, header),
+			collector, false);
+	hashRead(0);
+	if (!headerValid || (output != nullptr && !output->writeHeader())) {
+		return false;
 	}
-	return true;
-}
 
-bool isFloat(std::string_view str)
-{
-	float value = 0.0f;
-	auto result = std::from_chars(str.data(), str.data() + str.size(), value);
-	// Check for successful parse without worrying about the range
-	return result.ec == std::errc();
+	if (pool != nullptr) {
+		MemoryBlockReader blocks(remaining, options.blockSize);
+		std::optional<HashingBlockReader> hashing;
+		if (contentHash != nullptr) {
+			hashing.emplace(blocks, contents, *contentHash);
+		}
+		BlockReader &reader = hashing ? static_cast<BlockReader &>(*hashing) : blocks;
+		return validateBodyParallel(reader, *pool, collector, lineNumber + 1, &header, options.profile, output)
+			&& collector.errorCount() == 0;
+	}
+	validateBodySerial(nextLine, collector, lineNumber, header, options.profile);
+	hashRead(0);
+	return collector.errorCount() == 0;
 }
 
-bool isBoolean(std::string_view value)
+// Compressed input: lines are read from the decompressing stream
+bool validateStream(std::istream &inf, std::string const &fileName, ThreadPool *pool,
+	ValidationOptions const &options, ErrorCollector &collector, HeaderModel &header, FilteredOutput *output)
 {
-	return value == "0" || value == "1";
-}
+	std::string buffer;
+	auto nextLine = streamLines(inf, buffer);
 
-bool isNumericChromosome(std::string_view chrom)
-{
-	if (chrom.empty()) {
+	uint64_t lineNumber = 0;
+	if (!headerComplete(validateHeaderSection(outputHeaderLines(nextLine, output), collector, lineNumber, header),
+			collector, inf.bad(), fileName)
+		|| (output != nullptr && !output->writeHeader())) {
 		return false;
 	}
 
-	// Check for numeric chromosomes (1-22)
-	int num = 0;
-	auto [ptr, ec] = std::from_chars(chrom.data(), chrom.data() + chrom.size(), num);
-	return ec == std::errc() && num >= 1 && num <= 22;
-}
+	if (pool != nullptr) {
+		StreamBlockReader reader(inf, options.blockSize);
+		validateBodyParallel(reader, *pool, collector, lineNumber + 1, &header, options.profile, output);
+	} else {
+		validateBodySerial(nextLine, collector, lineNumber, header, options.profile);
+	}
+	bool const valid = collector.errorCount() == 0;
 
-bool isHumanChromosome(std::string_view chrom)
-{
-	// Handle common prefixes
-	if (chrom.starts_with("chr")) {
-		chrom.remove_prefix(3); // Remove "chr" prefix
+	// A decompression error surfaces as a bad stream rather than as an early end of input
+	if (valid && inf.bad()) {
+		diagnostics() << "Failed to read or decompress file: " << fileName << '\n';
+		return false;
 	}
+	return valid;
+}
 
-	// Check for standard and sex chromosomes
-	if (isNumericChromosome(chrom) || chrom == "X" || chrom == "Y" || chrom == "MT" || chrom == "M") {
+// Lines of a BGZF file and their virtual offsets
+class BgzfLines {
+public:
+	explicit BgzfLines(std::istream &compressed)
+		: cursor(compressed)
+	{
+	}
+	bool readLine(std::string_view &line)
+	{
+		if (!cursor.readLine(buffer)) {
+			return false;
+		}
+		line = buffer;
 		return true;
 	}
+	uint64_t tell() const
+	{
+		return cursor.tell();
+	}
+	void seek(uint64_t offset)
+	{
+		cursor.seek(offset);
+	}
 
-	// Check for unplaced or alternative sequences like 'chrUn_' or 'KI'
-	if (chrom.starts_with("Un_") || chrom.starts_with("KI") || chrom.contains("_KI")) {
+private:
+	BgzfCursor cursor;
+	std::string buffer;
+};
+
+// Lines of an uncompressed file and their byte offsets; with contentHash, each line read is hashed into it, so that
+// skipping ahead to a checkpoint leaves a gap
+class MappedLines {
+public:
+	MappedLines(std::string_view contents, ContentHash *contentHash)
+		: contents(contents)
+		, contentHash(contentHash)
+	{
+	}
+	bool readLine(std::string_view &line)
+	{
+		if (position == contents.size()) {
+			return false;
+		}
+		std::string_view const rest = contents.substr(position);
+		auto const newline = rest.find('\n');
+		line = rest.substr(0, newline);
+		size_t const size = newline == std::string_view::npos ? rest.size() : newline + 1;
+		if (contentHash != nullptr) {
+			contentHash->update(position, rest.substr(0, size));
+		}
+		position += size;
 		return true;
 	}
+	uint64_t tell() const
+	{
+		return position;
+	}
+	void seek(uint64_t offset)
+	{
+		position = std::min<uint64_t>(offset, contents.size());
+	}
 
+private:
+	std::string_view contents;
+	ContentHash *contentHash;
+	size_t position = 0;
+};
+
+// Moves lines past the last line checkpoint validated, false, leaving lines where they were, if that line is not
+// there any more
+template<typename Lines>
+bool resumeAt(Lines &lines, Checkpoint const &checkpoint)
+{
+	uint64_t const start = lines.tell();
+	lines.seek(checkpoint.lineOffset);
+	std::string_view line;
+	if (lines.readLine(line) && checkpointHash(checkpointHashSeed, line) == checkpoint.lineHash) {
+		return true;
+	}
+	lines.seek(start);
 	return false;
 }
 
-bool checkFormatAndSamples(std::vector<std::string_view> const &fields, size_t formatIndex)
+// --checkpoint: serial validation that continues from the checkpoint of an earlier run when the header and the
+// line it stopped at are unchanged, and records a new one every options.checkpointBlocks blocks while the file is
+// valid so far, and once more at its end. The blocks are told apart by the top bits of the offsets, which for BGZF
+// are those of the compressed block and for uncompressed input count 64 KiB pieces.
+template<typename Lines>
+bool validateResumable(Lines &lines, std::string const &fileName, ValidationOptions const &options,
+	ErrorCollector &collector, HeaderModel &header)
 {
-	if (formatIndex >= fields.size()) {
-		std::cerr << "FORMAT field missing or invalid\n";
+	auto nextLine = [&lines](std::string_view &line) {
+		ScopedStageTimer timer(StatsStage::Read);
+		if (!lines.readLine(line)) {
+			return false;
+		}
+		countStats(StatsCounter::Bytes, line.size() + 1);
+		return true;
+	};
+
+	Checkpoint next {
+		.headerHash = checkpointHashSeed,
+		.checks = checksDescription(options),
+		.line = 0,
+		.lineOffset = 0,
+		.lineHash = 0,
+		.runs = {},
+	};
+	auto hashedLine = [&nextLine, &next](std::string_view &line) {
+		if (!nextLine(line)) {
+			return false;
+		}
+		next.headerHash = checkpointHash(checkpointHash(next.headerHash, line), "\n");
+		return true;
+	};
+	uint64_t lineNumber = 0;
+	if (!headerComplete(validateHeaderSection(hashedLine, collector, lineNumber, header), collector, false)) {
 		return false;
 	}
 
-	auto formatDescriptors = split(fields[formatIndex], ':');
+	RecordOrder order;
+	Checkpoint previous;
+	if (readCheckpoint(fileName, previous) && previous.headerHash == next.headerHash
+		&& previous.checks == next.checks && previous.line > lineNumber && resumeAt(lines, previous)) {
+		lineNumber = previous.line;
+		// Merged into an empty order the runs cannot be out of order
+		std::vector<ValidationError> none;
+		order.merge(previous.runs, none);
+	}
 
-	for (size_t i = formatIndex + 1; i < fields.size(); ++i) {
-		auto sampleData = split(fields[i], ':');
-		if (sampleData.size() != formatDescriptors.size()) {
-			std::cerr << "Sample data does not match FORMAT descriptors\n";
-			return false;
+	auto record = [&](std::string_view line, uint64_t offset) {
+		next.line = lineNumber;
+		next.lineOffset = offset;
+		next.lineHash = checkpointHash(checkpointHashSeed, line);
+		next.runs.assign(order.runs().begin(), order.runs().end());
+		return writeCheckpoint(fileName, next);
+	};
+
+	ErrorSinkScope scope(collector.sink());
+	bool writing = true;
+	uint64_t block = lines.tell() >> 16;
+	uint64_t blocks = 0;
+	// Offset of the last line validated, recorded at the end if pending, that is unless a checkpoint was just written
+	// there
+	uint64_t lastOffset = 0;
+	bool pending = false;
+	std::string_view line;
+	while (true) {
+		uint64_t const offset = lines.tell();
+		if (!nextLine(line)) {
+			break;
 		}
-
-		for (size_t j = 0; j < formatDescriptors.size(); ++j) {
-			auto descriptor = formatDescriptors[j];
-			auto data = sampleData[j];
-
-			if (descriptor == "GT" && !isValidGenotype(data)) {
-				std::cerr << "Invalid genotype data: " << data << '\n';
-				return false;
-			}
-
-			if ((descriptor == "DP" || descriptor == "GQ") && !isNonNegativeInteger(data)) {
-				std::cerr << "Invalid data for " << descriptor << ": " << data << '\n';
-				return false;
-			}
-
-			if (descriptor == "AD" && !isListOfNonNegativeIntegers(data)) {
-				std::cerr << "Invalid allele depth data: " << data << '\n';
-				return false;
-			}
-
-			if (descriptor == "PL" && !isListOfNonNegativeIntegers(data)) {
-				std::cerr << "Invalid phred-scaled genotype likelihoods data: " << data << '\n';
-				return false;
-			}
-
-			if (descriptor == "MQ" && !isNonNegativeInteger(data)) {
-				std::cerr << "Invalid mapping quality data: " << data << '\n';
-				return false;
-			}
-
-			if (descriptor == "SB" && !isListOfNonNegativeIntegers(data)) {
-				std::cerr << "Invalid strand bias data: " << data << '\n';
-				return false;
-			}
-
-			if (descriptor == "MQ0" && !isNonNegativeInteger(data)) {
-				std::cerr << "Invalid MQ0 data: " << data << '\n';
-				return false;
-			}
-
-			if (descriptor == "HRun" && !isNonNegativeInteger(data)) {
-				std::cerr << "Invalid homopolymer run length data: " << data << '\n';
-				return false;
-			}
-
-			if (descriptor == "AF" && !isFloat(data)) {
-				std::cerr << "Invalid allele frequency data: " << data << '\n';
-				return false;
-			}
-
-			if (descriptor == "AC" && !isNonNegativeInteger(data)) {
-				std::cerr << "Invalid allele count data: " << data << '\n';
-				return false;
-			}
-
-			if (descriptor == "AN" && !isNonNegativeInteger(data)) {
-				std::cerr << "Invalid total number of alleles data: " << data << '\n';
-				return false;
-			}
-
-			if (descriptor == "BaseQRankSum" && !isFloat(data)) {
-				std::cerr << "Invalid Base Quality Rank Sum Test data: " << data << '\n';
-				return false;
-			}
-
-			if (descriptor == "ReadPosRankSum" && !isFloat(data)) {
-				std::cerr << "Invalid Read Position Rank Sum Test data: " << data << '\n';
-				return false;
-			}
-
-			if (descriptor == "FS" && !isFloat(data)) {
-				std::cerr << "Invalid Fisher Strand Bias data: " << data << '\n';
-				return false;
-			}
-
-			if (descriptor == "SOR" && !isFloat(data)) {
-				std::cerr << "Invalid Strand Odds Ratio data: " << data << '\n';
-				return false;
-			}
-
-			if (descriptor == "MQRankSum" && !isFloat(data)) {
-				std::cerr << "Invalid Mapping Quality Rank Sum Test data: " << data << '\n';
-				return false;
-			}
-
-			if (descriptor == "QD" && !isFloat(data)) {
-				std::cerr << "Invalid Quality by Depth data: " << data << '\n';
-				return false;
-			}
-
-			if (descriptor == "RPA" && !isListOfNonNegativeIntegers(data)) {
-				std::cerr << "Invalid Repeat unit number data: " << data << '\n';
-				return false;
-			}
-
-			if (descriptor == "RU" && data.empty()) {
-				std::cerr << "Invalid Repeat unit data: " << data << '\n';
-				return false;
-			}
-
-			if (descriptor == "STR" && !isBoolean(data)) {
-				std::cerr << "Invalid Short Tandem Repeat data: " << data << '\n';
-				return false;
+		collector.sink().setLine(++lineNumber);
+		order.setLine(lineNumber);
+		if (!validateBodyLine(line, &header, &order, options.profile) && !collector.lineFailed()) {
+			break;
+		}
+		if (!writing || collector.errorCount() != 0) {
+			continue;
+		}
+		lastOffset = offset;
+		pending = true;
+		uint64_t const lineBlock = lines.tell() >> 16;
+		if (lineBlock != block) {
+			block = lineBlock;
+			if (++blocks % options.checkpointBlocks == 0) {
+				writing = record(line, offset);
+				pending = false;
 			}
-
-			// Additional checks for other descriptors can be added here
 		}
 	}
-
-	return true;
-}
-
-int stringViewToInt(std::string_view sv)
-{
-	int value = 0;
-	auto [ptr, ec] = std::from_chars(sv.data(), sv.data() + sv.size(), value);
-	if (ec == std::errc::invalid_argument || ec == std::errc::result_out_of_range) {
-		throw std::runtime_error("Conversion error");
+	if (collector.errorCount() != 0) {
+		return false;
 	}
-	return value;
-}
-
-float stringViewToFloat(std::string_view sv)
-{
-	float value = 0;
-	auto [ptr, ec] = std::from_chars(sv.data(), sv.data() + sv.size(), value);
-	if (ec == std::errc::invalid_argument || ec == std::errc::result_out_of_range) {
-		throw std::runtime_error("Conversion error");
+	if (writing && pending) {
+		lines.seek(lastOffset);
+		lines.readLine(line);
+		record(line, lastOffset);
 	}
-	return value;
+	return true;
 }
 
-bool checkDataLines(std::string_view line)
+// Region and per-contig validation: the header is read from the start of the file, the data lines through the
+// tabix or CSI index next to it
+bool validateIndexed(std::string const &fileName, ThreadPool *pool, ValidationOptions const &options,
+	ErrorCollector &collector, HeaderModel &header)
 {
-	auto fields = split(line, '\t');
-
-	// Basic check for the number of fields
-	size_t const expectedFieldCount = 8;
-	if (fields.size() < expectedFieldCount) {
-		std::cerr << "Invalid data line (not enough fields): " << line << '\n';
+	std::vector<Region> regions;
+	for (auto const &text : options.regions) {
+		Region region;
+		if (!parseRegion(text, region)) {
+			diagnostics() << "Invalid region: " << text << '\n';
+			return false;
+		}
+		regions.push_back(std::move(region));
+	}
+	if (!options.regionsFile.empty() && !readRegionsFile(options.regionsFile, regions)) {
 		return false;
 	}
 
-	// Validate CHROM - simple check for non-empty string
-	if (fields[0].empty()) {
-		std::cerr << "Invalid CHROM field: " << fields[0] << '\n';
+	std::ifstream file(fileName, std::ios_base::in | std::ios_base::binary);
+	if (!file.is_open()) {
+		diagnostics() << "Failed to open file: " << fileName << '\n';
 		return false;
 	}
-
-	// Check if CHROM field is a human chromosome
-	if (!isHumanChromosome(fields[0])) {
-		std::cerr << "Non-human chromosome found: " << fields[0] << '\n';
+	if (!isBgzf(file)) {
+		diagnostics() << "Region validation needs a BGZF-compressed, indexed file: " << fileName << '\n';
 		return false;
 	}
 
-	// Validate POS - should be a positive integer
-	try {
-		int pos = stringViewToInt(fields[1]);
-		if (pos <= 0) {
-			std::cerr << "Invalid POS field: " << fields[1] << '\n';
+	std::optional<TabixIndex> index;
+	for (std::string const suffix : {".tbi", ".csi"}) {
+		std::string const indexName = fileName + suffix;
+		if (!std::filesystem::exists(indexName)) {
+			continue;
+		}
+		try {
+			index = TabixIndex::load(indexName);
+		} catch (std::runtime_error const &e) {
+			diagnostics() << "Failed to read index: " << indexName << ": " << e.what() << '\n';
 			return false;
 		}
-	} catch (std::invalid_argument &e) {
-		std::cerr << "Invalid POS field (not an integer): " << fields[1] << '\n';
+		break;
+	}
+	if (!index) {
+		diagnostics() << "No .tbi or .csi index found for: " << fileName << '\n';
 		return false;
 	}
+	if (options.parallelContigs && regions.empty()) {
+		for (auto const &contig : index->contigs()) {
+			regions.push_back({.contig = contig});
+		}
+	}
 
-	// Validate ID - should be a string or '.'
-	if (fields[2] != "." && fields[2].empty()) {
-		std::cerr << "Invalid ID field: " << fields[2] << '\n';
-		return false;
+	{
+		BgzfReader bgzf(file, nullptr);
+		DecompressedBuffer in(bgzf);
+		std::istream inf(&in);
+		std::string buffer;
+		uint64_t lineNumber = 0;
+		if (!headerComplete(validateHeaderSection(streamLines(inf, buffer), collector, lineNumber, header),
+				collector, inf.bad(), fileName)) {
+			return false;
+		}
 	}
+	return validateRegions(fileName, *index, std::move(regions), collector, pool, &header, options.profile)
+		&& collector.errorCount() == 0;
+}
 
-	// Validate REF - should be one of A, C, G, T, N
-	if (!isValidBase(fields[3])) {
-		std::cerr << "Invalid REF field: " << fields[3] << '\n';
-		return false;
+// Validates a whole file on pool, or on the reading thread without one. With contentHash, the file's bytes are also
+// hashed into it as they are read; with output, the data lines are validated on pool and written to output.
+bool validateFile(std::string const &fileName, ThreadPool *pool, ValidationOptions const &options,
+	ErrorCollector &collector, HeaderModel &header, ContentHash *contentHash, FilteredOutput *output)
+{
+	if (fileName.ends_with(".vcf")) {
+		MappedFile file(fileName);
+		if (!file.isOpen()) {
+			diagnostics() << "Failed to open file: " << fileName << '\n';
+			return false;
+		}
+		if (options.checkpointBlocks != 0) {
+			MappedLines lines(file.contents(), contentHash);
+			return validateResumable(lines, fileName, options, collector, header);
+		}
+		return validateMappedFile(file, pool, options, collector, header, contentHash, output);
 	}
 
-	// Validate ALT field
-	if (!isValidAlt(fields[4])) { // Assuming ALT is the fifth column (0-based indexing)
-		std::cerr << "Invalid ALT field: " << fields[4] << '\n';
+	// Compressed input is read sequentially, ahead of the decompressor unless disabled
+	std::optional<ReadAheadBuffer> readAhead;
+	std::ifstream plainFile;
+	std::istream file(nullptr);
+	if (options.readAheadDepth != 0) {
+		readAhead.emplace(fileName, options.readAheadDepth, options.readBlockSize, options.readAheadThreads);
+		if (readAhead->isOpen()) {
+			file.rdbuf(&*readAhead);
+		}
+		if (contentHash != nullptr) {
+			readAhead->setBlockObserver(
+				[contentHash](uint64_t offset, std::string_view data) { contentHash->update(offset, data); });
+		}
+	} else {
+		plainFile.open(fileName, std::ios_base::in | std::ios_base::binary);
+		if (plainFile.is_open()) {
+			file.rdbuf(plainFile.rdbuf());
+		}
+		if (contentHash != nullptr) {
+			contentHash->leaveGap();
+		}
+	}
+	if (file.rdbuf() == nullptr) {
+		diagnostics() << "Failed to open file: " << fileName << '\n';
 		return false;
 	}
 
-	// Validate QUAL - should be a float or '.'
-	if (fields[5] != ".") {
-		try {
-			float qual = stringViewToFloat(fields[5]);
-			if (qual < 0) {
-				std::cerr << "Invalid QUAL field: " << fields[5] << '\n';
+	if (options.checkpointBlocks != 0) {
+		if (isBgzf(file)) {
+			try {
+				BgzfLines lines(file);
+				return validateResumable(lines, fileName, options, collector, header);
+			} catch (std::runtime_error const &) {
+				collector.flush();
+				diagnostics() << "Failed to read or decompress file: " << fileName << '\n';
 				return false;
 			}
-		} catch (std::invalid_argument &e) {
-			std::cerr << "Invalid QUAL field (not a float): " << fields[5] << '\n';
+		}
+		diagnostics() << "Checkpoints need BGZF or uncompressed input, validating from the start: " << fileName
+					  << '\n';
+	}
+
+	bool const bgzf = isBgzf(file);
+	std::unique_ptr<Decompressor> decompressor;
+	if (bgzf) {
+		decompressor = std::make_unique<BgzfReader>(file, pool);
+	} else {
+		// Plain gzip, bzip2 and zstd can only be decompressed as one stream
+		CompressionFormat const format = detectCompression(file);
+		decompressor = makeStreamDecompressor(format, file);
+		if (!decompressor) {
+			diagnostics() << "Support for " << compressionName(format) << " input is not built in: " << fileName
+						  << '\n';
 			return false;
 		}
 	}
+	DecompressedBuffer in(*decompressor);
 
-	// Validate FILTER - should be a string or '.'
-	if (fields[6] != "." && fields[6].empty()) {
-		std::cerr << "Invalid FILTER field: " << fields[6] << '\n';
-		return false;
+	// Decompression overlaps validation on a thread of its own unless the pool already inflates BGZF in parallel
+	std::optional<PipelinedInput> pipeline;
+	if (options.inflateAheadDepth != 0 && (!bgzf || pool == nullptr)) {
+		pipeline.emplace(in, options.inflateAheadDepth, size_t {1} << 20);
 	}
+	std::istream inf(pipeline ? static_cast<std::streambuf *>(&*pipeline) : &in);
+	return validateStream(inf, fileName, pool, options, collector, header, output);
+}
 
-	// Validate INFO - additional information in key=value format; complex validation can be added here
-	if (fields[7].empty()) {
-		std::cerr << "Invalid INFO field: " << fields[7] << '\n';
-		return false;
+// With contentHash, the file's bytes are also hashed into it as they are read
+bool validateInput(std::string const &fileName, ValidationOptions const &options, ErrorCollector &collector,
+	HeaderModel &header, ThreadPool *sharedPool, ContentHash *contentHash)
+{
+	// One pool shared by BGZF inflation and data line validation; per-contig validation wants one by default, and
+	// filtering one of at least one worker since the output is written by the collector of the block pipeline
+	unsigned const threads = options.parallelContigs && options.threads == 1
+		? std::max(1u, std::thread::hardware_concurrency())
+		: options.threads;
+	bool const filtering = !options.filterOutput.empty();
+	std::optional<ThreadPool> ownPool;
+	if (sharedPool == nullptr && (threads > 1 || filtering)) {
+		ownPool.emplace(threads);
 	}
+	ThreadPool *const pool = sharedPool != nullptr ? sharedPool : ownPool ? &*ownPool : nullptr;
 
-	// Check FORMAT and sample-specific columns
-	size_t const formatFieldIndex = 8; // FORMAT field is the 9th column (0-based index)
-	if (!checkFormatAndSamples(fields, formatFieldIndex)) {
+	if (!options.regions.empty() || !options.regionsFile.empty() || options.parallelContigs) {
+		return validateIndexed(fileName, pool, options, collector, header);
+	}
+	if (!filtering) {
+		return validateFile(fileName, pool, options, collector, header, contentHash, nullptr);
+	}
+
+	std::unique_ptr<LineWriter> passed = openLineWriter(options.filterOutput, *pool);
+	std::unique_ptr<LineWriter> rejects;
+	if (!passed || (!options.rejectsOutput.empty() && !(rejects = openLineWriter(options.rejectsOutput, *pool)))) {
 		return false;
 	}
+	FilteredOutput output(std::move(passed), std::move(rejects));
+	bool const valid = validateFile(fileName, pool, options, collector, header, contentHash, &output);
+	collector.flush();
+	if (!output.finish()) {
+		diagnostics() << "Failed to write file: " << options.filterOutput
+					  << (options.rejectsOutput.empty() ? "" : " or " + options.rejectsOutput) << '\n';
+		return false;
+	}
+	diagnostics() << output.passedLines() << " data lines written, " << output.rejectedLines() << " rejected\n";
+	return valid;
+}
 
-	return true;
+// Validates without the cache
+bool validateUncached(
+	std::string const &fileName, ValidationOptions const &options, ThreadPool *pool, ContentHash *contentHash)
+{
+	// Errors about declared FORMAT keys refer to names held by the header, so it outlives the collector
+	HeaderModel header;
+	header.setSampleSelection(options.samples);
+	ErrorCollector collector(options.maxErrors);
+	bool const valid = validateInput(fileName, options, collector, header, pool, contentHash);
+	collector.flush();
+	// Filtering reports how many lines it rejected instead
+	if (options.maxErrors != 1 && collector.errorCount() != 0 && options.filterOutput.empty()) {
+		diagnostics() << collector.errorCount() << (collector.errorCount() == 1 ? " invalid line" : " invalid lines")
+				  << (collector.limitReached() ? " (stopped at --max-errors)\n" : "\n");
+	}
+	return valid;
+}
+
+// Everything a cached result depends on besides the file. The identity of the executable stands in for the
+// validator version, so that any rebuild starts over.
+std::string cacheSettings(ValidationOptions const &options)
+{
+	std::string build = __DATE__ " " __TIME__;
+	if (FileIdentity program; fileIdentity("/proc/self/exe", program)) {
+		build = std::to_string(program.inode) + ' ' + std::to_string(program.size) + ' '
+			+ std::to_string(program.modified);
+	}
+	return "build " + build + " checks " + checksDescription(options) + " max-errors "
+		+ std::to_string(options.maxErrors);
+}
+
+} // namespace
+
+bool validateFormat(std::string const &fileName, ValidationOptions const &options, ThreadPool *pool)
+{
+	// Region validation leaves out most of the file, so its result is not the file's; filtering has to write the output
+	bool const cacheable = !options.cacheDirectory.empty() && options.regions.empty() && options.regionsFile.empty()
+		&& !options.parallelContigs && options.filterOutput.empty();
+	FileIdentity identity;
+	if (!cacheable || !fileIdentity(fileName, identity)) {
+		return validateUncached(fileName, options, pool, nullptr);
+	}
+
+	ResultCache const cache(options.cacheDirectory, cacheSettings(options));
+	if (CachedResult cached; cache.lookup(fileName, cached) && cached.identity.size == identity.size) {
+		bool hit = cached.identity == identity;
+		if (options.cacheVerify) {
+			uint64_t hash = 0;
+			hit = ContentHash::hashFile(fileName, cached.hashedSize, hash) && hash == cached.contentHash;
+			if (hit && cached.identity != identity) {
+				cached.identity = identity;
+				cache.store(fileName, cached);
+			}
+		}
+		if (hit) {
+			diagnostics() << cached.messages;
+			return cached.valid;
+		}
+	}
+
+	ContentHash contentHash;
+	std::ostringstream messages;
+	bool valid = false;
+	{
+		DiagnosticsRedirect redirect(messages);
+		valid = validateUncached(fileName, options, pool, &contentHash);
+	}
+	diagnostics() << messages.view();
+	// No entry for a file that changed while it was being validated, or whose hash misses part of what was read
+	FileIdentity after;
+	uint64_t hash = 0;
+	uint64_t hashedSize = 0;
+	if (fileIdentity(fileName, after) && after == identity && contentHash.finish(hash, hashedSize)) {
+		CachedResult const result {
+			.identity = identity,
+			.contentHash = hash,
+			.hashedSize = hashedSize,
+			.valid = valid,
+			.messages = std::move(messages).str(),
+		};
+		cache.store(fileName, result);
+	}
+	return valid;
 }
@@ -0,0 +1,171 @@
+#include "header_model.hxx"
+
+#include "vcf_validation.hxx"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <utility>
+
+uint64_t HeaderModel::Generation::next()
+{
+	// 0 is left for no model at all
+	static std::atomic<uint64_t> counter {1};
+	return counter.fetch_add(1, std::memory_order_relaxed);
+}
+
+FieldDefinition const *HeaderModel::findInfo(std::string_view id) const
+{
+	auto const found = info.find(id);
+	return found != info.end() ? &found->second.definition : nullptr;
+}
+
+FieldDefinition const *HeaderModel::findFormat(std::string_view id) const
+{
+	auto const found = format.find(id);
+	return found != format.end() ? &found->second.definition : nullptr;
+}
+
+bool HeaderModel::hasFilter(std::string_view id) const
+{
+	return filters.contains(id);
+}
+
+FormatKeyCheck const *HeaderModel::declaredFormatCheck(std::string_view id) const
+{
+	auto const found = format.find(id);
+	if (found == format.end() || found->second.check.check == nullptr) {
+		return nullptr;
+	}
+	return &found->second.check;
+}
+
+FormatKeyCheck const *HeaderModel::declaredFormatKey(std::string_view id) const
+{
+	auto const found = format.find(id);
+	return found != format.end() ? &found->second.check : nullptr;
+}
+
+void HeaderModel::clear()
+{
+	version.clear();
+	info.clear();
+	infoKeys.clear();
+	infoIndex.clear();
+	format.clear();
+	filters.clear();
+	contigList.clear();
+	contigIndex.clear();
+	sampleNames.clear();
+	selectedIndices.clear();
+	unknownNames.clear();
+	generationNumber.value = Generation::next();
+}
+
+void HeaderModel::setFileFormat(std::string_view value)
+{
+	version = value;
+}
+
+void HeaderModel::addInfo(std::string_view id, FieldDefinition definition)
+{
+	auto [entry, added] = info.try_emplace(std::string(id));
+	if (!added) {
+		return;
+	}
+	entry->second.definition = std::move(definition);
+	entry->second.message = "Invalid INFO entry for " + entry->first + ": ";
+	infoIndex.insert(entry->first, static_cast<uint32_t>(infoKeys.size()));
+	infoKeys.push_back({entry->first, &entry->second.definition, entry->second.message});
+}
+
+void HeaderModel::addFormat(std::string_view id, FieldDefinition definition)
+{
+	auto [entry, added] = format.try_emplace(std::string(id));
+	if (!added) {
+		return;
+	}
+	generationNumber.value = Generation::next();
+	FormatDefinition &declared = entry->second;
+	declared.definition = std::move(definition);
+	declared.message = "Invalid data for " + entry->first + ": ";
+	declared.check.key = entry->first;
+	declared.check.message = declared.message;
+	switch (declared.definition.type) {
+	case ValueType::Integer:
+		declared.check.check = isIntegerValues;
+		declared.check.checkColumn = firstInvalidCell<isIntegerValues>;
+		break;
+	case ValueType::Float:
+		declared.check.check = isFloatValues;
+		declared.check.checkColumn = firstInvalidCell<isFloatValues>;
+		break;
+	case ValueType::Character:
+		declared.check.check = isCharacterValues;
+		declared.check.checkColumn = firstInvalidCell<isCharacterValues>;
+		break;
+	case ValueType::Flag: // Not allowed for FORMAT keys, and nothing to check about String values
+	case ValueType::String:
+		break;
+	}
+}
+
+void HeaderModel::addFilter(std::string_view id)
+{
+	filters.emplace(id);
+}
+
+void HeaderModel::addContig(ContigDefinition contig)
+{
+	if (findContig(contig.id) != nullptr) {
+		return;
+	}
+	contig.human = isHumanChromosome(contig.id);
+	contigList.push_back(std::move(contig));
+	contigIndex.insert(contigList.back().id, static_cast<uint32_t>(contigList.size() - 1));
+}
+
+void HeaderModel::setSamples(std::vector<std::string> names)
+{
+	sampleNames = std::move(names);
+	selectedIndices.clear();
+	unknownNames.clear();
+	for (auto const &name : selection.names) {
+		auto const found = std::ranges::find(sampleNames, name);
+		if (found == sampleNames.end()) {
+			unknownNames.push_back(name);
+			continue;
+		}
+		selectedIndices.push_back(static_cast<uint32_t>(found - sampleNames.begin()));
+	}
+	std::ranges::sort(selectedIndices);
+	auto const duplicates = std::ranges::unique(selectedIndices);
+	selectedIndices.erase(duplicates.begin(), duplicates.end());
+}
+
+void HeaderModel::setSampleSelection(SampleSelection value)
+{
+	selection = std::move(value);
+	rateThreshold = selection.rate >= 1 ? uint64_t {1} << 32
+										: static_cast<uint64_t>(std::ldexp(std::max(selection.rate, 0.0), 32));
+}
+
+bool HeaderModel::checksSamplesOf(std::string_view chrom, std::string_view pos) const
+{
+	if (rateThreshold > UINT32_MAX) {
+		return true;
+	}
+	// FNV-1a, then the MurmurHash3 finalizer so that neighbouring positions land far apart
+	uint64_t hash = 0xcbf29ce484222325;
+	for (std::string_view const part : {chrom, std::string_view("\t"), pos}) {
+		for (char const c : part) {
+			hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3;
+		}
+	}
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccd;
+	hash ^= hash >> 33;
+	hash *= 0xc4ceb9fe1a85ec53;
+	hash ^= hash >> 33;
+	return (hash >> 32) < rateThreshold;
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "format_checks.hxx"
+#include "perfect_hash.hxx"
+#include "sample_selection.hxx"
+#include "value_count.hxx"
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <optional>
+#include <set>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class ValueType : uint8_t
+{
+	Integer,
+	Float,
+	Flag,
+	Character,
+	String,
+};
+
+struct FieldDefinition {
+	ValueCount number;
+	ValueType type = ValueType::String;
+	std::string description;
+};
+
+// An INFO key as data lines look it up, with the message printed in front of an invalid entry
+struct InfoKeyDefinition {
+	std::string_view id;
+	FieldDefinition const *definition = nullptr;
+	std::string_view message;
+};
+
+struct ContigDefinition {
+	std::string id;
+	std::optional<uint64_t> length;
+	bool human = false; // isHumanChromosome(id), filled in by the model
+};
+
+// What the meta-information and column header lines declare, built while the header is validated and read-only
+// afterwards, so worker threads can share it
+class HeaderModel {
+public:
+	HeaderModel() = default;
+	// Lookup tables and FORMAT checks point into the model's map nodes and deque elements, which a move keeps but a
+	// copy would not
+	HeaderModel(HeaderModel const &) = delete;
+	HeaderModel &operator=(HeaderModel const &) = delete;
+	HeaderModel(HeaderModel &&) = default;
+	HeaderModel &operator=(HeaderModel &&) = default;
+
+	std::string_view fileFormat() const
+	{
+		return version;
+	}
+	FieldDefinition const *findInfo(std::string_view id) const;
+	// Same as findInfo() through a perfect hash of the declared keys
+	InfoKeyDefinition const *findInfoKey(std::string_view id) const
+	{
+		uint32_t const found = infoIndex.find(id);
+		return found != PerfectHashIndex::npos ? &infoKeys[found] : nullptr;
+	}
+	FieldDefinition const *findFormat(std::string_view id) const;
+	bool hasFilter(std::string_view id) const;
+	// Through a perfect hash of the declared contigs, cheap enough for every record's CHROM
+	ContigDefinition const *findContig(std::string_view id) const
+	{
+		uint32_t const found = contigIndex.find(id);
+		return found != PerfectHashIndex::npos ? &contigList[found] : nullptr;
+	}
+	// In header order
+	std::deque<ContigDefinition> const &contigs() const
+	{
+		return contigList;
+	}
+	std::vector<std::string> const &samples() const
+	{
+		return sampleNames;
+	}
+	// A number no other model has, nor this one had before its last FORMAT declaration or move, so that what was
+	// resolved against a model is not taken for the model built later at the same address
+	uint64_t generation() const
+	{
+		return generationNumber.value;
+	}
+
+	// Set before the header is read; the column header line resolves its names
+	void setSampleSelection(SampleSelection selection);
+	SampleSelection const &sampleSelection() const
+	{
+		return selection;
+	}
+	// Indices of the selected samples in column order, empty if every sample is checked
+	std::span<uint32_t const> selectedSamples() const
+	{
+		return selectedIndices;
+	}
+	// Names of the selection the column header line does not have
+	std::span<std::string const> unknownSamples() const
+	{
+		return unknownNames;
+	}
+	// Whether the record at chrom and pos is one of those whose samples are checked at the selection's rate
+	bool checksSamplesOf(std::string_view chrom, std::string_view pos) const;
+
+	// Check derived from the ##FORMAT Type of a key the built-in table does not cover, nullptr if the key is not
+	// declared or its values are not checked (String). The check outlives the model's use by the validators.
+	FormatKeyCheck const *declaredFormatCheck(std::string_view id) const;
+	// The same for any declared key, with check and checkColumn nullptr where its Type is not checked
+	FormatKeyCheck const *declaredFormatKey(std::string_view id) const;
+
+	// Forgets what the header declared, keeping the sample selection and the memory of the lists and lookup tables
+	// for the next header. The generation changes as well.
+	void clear();
+
+	// Filled by the header parser; later definitions of the same ID are ignored
+	void setFileFormat(std::string_view value);
+	void addInfo(std::string_view id, FieldDefinition definition);
+	void addFormat(std::string_view id, FieldDefinition definition);
+	void addFilter(std::string_view id);
+	void addContig(ContigDefinition contig);
+	void setSamples(std::vector<std::string> names);
+
+private:
+	// Drawn afresh for both models of a move
+	struct Generation {
+		Generation()
+			: value(next())
+		{
+		}
+		Generation(Generation &&other) noexcept
+			: value(next())
+		{
+			other.value = next();
+		}
+		Generation &operator=(Generation &&other) noexcept
+		{
+			value = next();
+			other.value = next();
+			return *this;
+		}
+
+		static uint64_t next();
+
+		uint64_t value;
+	};
+
+	struct InfoDefinition {
+		FieldDefinition definition;
+		std::string message;
+	};
+	struct FormatDefinition {
+		FieldDefinition definition;
+		std::string message;
+		FormatKeyCheck check {};
+	};
+
+	std::string version;
+	std::map<std::string, InfoDefinition, std::less<>> info;
+	std::vector<InfoKeyDefinition> infoKeys;
+	PerfectHashIndex infoIndex;
+	std::map<std::string, FormatDefinition, std::less<>> format;
+	std::set<std::string, std::less<>> filters;
+	std::deque<ContigDefinition> contigList;
+	PerfectHashIndex contigIndex;
+	std::vector<std::string> sampleNames;
+	SampleSelection selection;
+	std::vector<uint32_t> selectedIndices;
+	std::vector<std::string> unknownNames;
+	// Records whose hash falls below this are checked, out of 2^32; above that every record is
+	uint64_t rateThreshold = uint64_t {1} << 32;
+	Generation generationNumber;
+};
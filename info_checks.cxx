@@ -0,0 +1,64 @@
+#include "info_checks.hxx"
+
+#include "delimiter_scan.hxx"
+#include "error_sink.hxx"
+#include "format_checks.hxx"
+#include "header_model.hxx"
+
+#include <algorithm>
+
+namespace {
+
+bool isValidInfoValue(FieldDefinition const &definition, bool hasValue, std::string_view value, uint32_t altAlleles)
+{
+	if (definition.type == ValueType::Flag) {
+		return !hasValue;
+	}
+	if (!hasValue || value.empty()) {
+		return false;
+	}
+	if (value == ".") {
+		return true;
+	}
+
+	// Values are counted by their separators; Number=G is taken as diploid, INFO having no ploidy of its own
+	uint64_t const expected = expectedValueCount(definition.number, altAlleles);
+	if (expected != 0 && static_cast<uint64_t>(std::ranges::count(value, ',')) + 1 != expected) {
+		return false;
+	}
+	switch (definition.type) {
+	case ValueType::Integer:
+		return isIntegerValues(value);
+	case ValueType::Float:
+		return isFloatValues(value);
+	case ValueType::Character:
+		return isCharacterValues(value);
+	case ValueType::Flag:
+	case ValueType::String:
+		break;
+	}
+	return true;
+}
+
+} // namespace
+
+bool checkInfoField(std::string_view info, HeaderModel const &header, uint32_t altAlleles)
+{
+	if (info == ".") {
+		return true;
+	}
+	return forEachField<';'>(info, [&](std::string_view entry) {
+		size_t const equals = entry.find('=');
+		std::string_view const key = entry.substr(0, equals);
+		InfoKeyDefinition const *declared = header.findInfoKey(key);
+		if (declared == nullptr) {
+			return true;
+		}
+		bool const hasValue = equals != std::string_view::npos;
+		if (!isValidInfoValue(*declared->definition, hasValue, hasValue ? entry.substr(equals + 1) : "", altAlleles)) {
+			reportInfoError(declared->id, declared->message, entry);
+			return false;
+		}
+		return true;
+	});
+}
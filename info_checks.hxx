@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+class HeaderModel;
+
+// Checks the entries of a non-empty INFO column against the ##INFO declarations of header: Flags carry no value,
+// other types need one whose values parse as the declared Type and, for a fixed Number or Number=A, R or G of a
+// record with altAlleles ALT alleles, come in that count. '.' stands for a missing column or value. Keys the header
+// does not declare are not checked, nor are empty entries such as those of a trailing ';' or of ';;'.
+bool checkInfoField(std::string_view info, HeaderModel const &header, uint32_t altAlleles = 1);
@@ -0,0 +1,50 @@
+#include "mapped_file.hxx"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(std::string const &fileName)
+{
+	int const fd = ::open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return;
+	}
+
+	struct stat status {};
+	if (::fstat(fd, &status) == 0 && S_ISREG(status.st_mode)) {
+		size = static_cast<size_t>(status.st_size);
+		if (size == 0) {
+			open = true; // Nothing to map
+		} else {
+			address = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (address == MAP_FAILED) {
+				address = nullptr;
+				size = 0;
+			} else {
+				::madvise(address, size, MADV_SEQUENTIAL);
+				open = true;
+			}
+		}
+	}
+	// The mapping stays valid after the descriptor is closed
+	::close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+	if (address != nullptr) {
+		::munmap(address, size);
+	}
+}
+
+bool MappedFile::isOpen() const
+{
+	return open;
+}
+
+std::string_view MappedFile::contents() const
+{
+	return {static_cast<char const *>(address), size};
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Read-only memory mapping of a whole file, advised for sequential access
+class MappedFile {
+public:
+	explicit MappedFile(std::string const &fileName);
+	~MappedFile();
+
+	MappedFile(MappedFile const &) = delete;
+	MappedFile &operator=(MappedFile const &) = delete;
+
+	bool isOpen() const;
+	std::string_view contents() const;
+
+private:
+	void *address = nullptr;
+	size_t size = 0;
+	bool open = false;
+};
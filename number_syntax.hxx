@@ -0,0 +1,101 @@
+#pragma once
+
+#include "char_class.hxx"
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <limits>
+#include <string_view>
+
+// Number checks that only look at the characters, for fields that are validated but never used as numbers.
+// startsWithNonNegative accepts exactly what the std::from_chars test it replaces accepted; isShortDecimal is the
+// fast path in front of one, looking for the shapes that need no range check.
+namespace number_syntax {
+
+namespace detail {
+// Decimal digits of the largest Integer, most significant first
+template<std::signed_integral Integer>
+constexpr auto maxDigits = [] {
+	std::array<char, std::numeric_limits<Integer>::digits10 + 1> digits {};
+	Integer value = std::numeric_limits<Integer>::max();
+	for (size_t i = digits.size(); i-- != 0; value /= 10) {
+		digits[i] = static_cast<char>('0' + value % 10);
+	}
+	return digits;
+}();
+} // namespace detail
+
+// Whether text starts with an Integer that is not negative, like a from_chars into Integer that may stop early
+// followed by value >= 0: an optional '-' (then only zeros) and a run of digits in range
+template<std::signed_integral Integer>
+bool startsWithNonNegative(std::string_view text)
+{
+	// Common case first: a few digits, too short to be out of range, tested without branching on each one
+	if (text.size() - 1 < std::numeric_limits<Integer>::digits10) {
+		bool allDigits = true;
+		for (char c : text) {
+			allDigits &= char_class::Digits::contains(c);
+		}
+		if (allDigits) {
+			return true;
+		}
+	}
+
+	char const *p = text.data();
+	char const *const end = p + text.size();
+	bool const negative = p != end && *p == '-';
+	p += negative;
+	char const *const digits = p;
+	// Leading zeros do not count toward the range
+	while (p != end && *p == '0') {
+		++p;
+	}
+	char const *const significant = p;
+	while (p != end && char_class::Digits::contains(*p)) {
+		++p;
+	}
+	if (p == digits) {
+		return false;
+	}
+	auto const size = static_cast<size_t>(p - significant);
+	if (negative) {
+		return size == 0; // -0
+	}
+	constexpr auto const &max = detail::maxDigits<Integer>;
+	if (size != max.size()) {
+		return size < max.size();
+	}
+	return std::string_view(significant, size) <= std::string_view(max.data(), max.size());
+}
+
+// Up to 15 digits with an optional sign and, when AllowPoint, one decimal point: always in range, so the values
+// written by most tools are accepted without a full parse. Integers are limited to 9 digits, which fit any int.
+template<bool AllowPoint>
+bool isShortDecimal(std::string_view item)
+{
+	size_t const start = item.starts_with('-') ? 1 : 0;
+	if (item.size() - start - 1 >= 15) {
+		return false;
+	}
+	bool seenPoint = false;
+	bool seenDigit = false;
+	for (size_t i = start; i < item.size(); ++i) {
+		if (char_class::Digits::contains(item[i])) {
+			seenDigit = true;
+		} else if (AllowPoint && item[i] == '.' && !seenPoint) {
+			seenPoint = true;
+		} else {
+			return false;
+		}
+	}
+	return seenDigit && (AllowPoint || item.size() - start <= 9);
+}
+
+// For a text isShortDecimal<true> accepts: whether its value is below zero
+inline bool isNegativeShortDecimal(std::string_view item)
+{
+	return item.starts_with('-') && item.find_first_not_of("-0.") != std::string_view::npos;
+}
+
+} // namespace number_syntax
@@ -0,0 +1,219 @@
+#include "parallel_validator.hxx"
+
+#include "block_reader.hxx"
+#include "error_sink.hxx"
+#include "filtered_output.hxx"
+#include "record_order.hxx"
+#include "thread_affinity.hxx"
+#include "thread_pool.hxx"
+#include "vcf_validation.hxx"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct BlockResult {
+	bool done = false;
+	uint64_t lines = 0;
+	// Empty unless the block has invalid lines
+	std::vector<ValidationError> errors;
+	// With output, the invalid lines, those past maxErrors included
+	std::vector<uint64_t> rejected;
+	// Sorted-order state of the block on its own, joined to the blocks before it by the collector
+	RecordOrder order;
+};
+
+// A block in flight and, once validated, its result. Blocks use the slots round-robin, so the text buffers and the
+// result vectors keep their capacity from block to block and the pipeline stops allocating once they have grown.
+struct BlockSlot {
+	TextBlock block;
+	BlockResult result;
+};
+
+// Errors per thread buffered before they are moved into the block's result
+constexpr size_t workerSinkCapacity = 64;
+
+struct PipelineState {
+	PipelineState(size_t slotCount, size_t maxErrors, HeaderModel const *header, ValidationProfile profile,
+		FilteredOutput *output)
+		: slots(slotCount)
+		, maxErrors(maxErrors)
+		, header(header)
+		, profile(profile)
+		, output(output)
+	{
+	}
+
+	std::mutex mutex;
+	std::condition_variable changed;
+	// Block i uses slots[i % slots.size()]; the blocks firstPending up to blocksRead are in flight
+	std::vector<BlockSlot> slots;
+	uint64_t firstPending = 0;
+	uint64_t blocksRead = 0;
+	size_t const maxErrors;
+	HeaderModel const *const header;
+	ValidationProfile const profile;
+	FilteredOutput *const output;
+	// Submitted tasks that have not finished yet; the pool outlives this pipeline
+	size_t outstanding = 0;
+	bool readerDone = false;
+	bool cancelled = false;
+
+	BlockSlot &slot(uint64_t index)
+	{
+		return slots[index % slots.size()];
+	}
+};
+
+// Line numbers of the errors count from the start of the block; stops after maxErrors invalid lines since the
+// collector cannot take more than that from one block, or with output goes on without recording their errors
+void validateBlock(TextBlock const &block, PipelineState const &state, BlockResult &result)
+{
+	thread_local ErrorSink sink(workerSinkCapacity);
+	sink.clear();
+	ErrorSinkScope scope(sink);
+
+	result.lines = 0;
+	result.errors.clear();
+	result.rejected.clear();
+	result.order.clear();
+	bool const filtering = state.output != nullptr;
+	size_t failedLines = 0;
+	forEachLine(block.text, [&](std::string_view line) {
+		sink.setLine(++result.lines);
+		result.order.setLine(result.lines);
+		if (validateBodyLine(line, state.header, &result.order, state.profile)) {
+			return true;
+		}
+		if (filtering) {
+			result.rejected.push_back(result.lines);
+		}
+		if (failedLines == state.maxErrors) {
+			sink.clear(); // Filtering past the limit, the errors before this line are in errors already
+			return true;
+		}
+		++failedLines;
+		if (sink.full() || failedLines == state.maxErrors) {
+			result.errors.insert(result.errors.end(), sink.errors().begin(), sink.errors().end());
+			sink.clear();
+		}
+		return failedLines < state.maxErrors || filtering;
+	});
+	result.errors.insert(result.errors.end(), sink.errors().begin(), sink.errors().end());
+}
+
+} // namespace
+
+bool validateBodyParallel(BlockReader &reader, ThreadPool &pool, ErrorCollector &collector, uint64_t firstLine,
+	HeaderModel const *header, ValidationProfile profile, FilteredOutput *output)
+{
+	// Enough blocks in flight to keep every worker busy while the collector waits for the oldest one
+	size_t const maxInFlight = static_cast<size_t>(pool.size()) * 2 + 2;
+
+	PipelineState state(maxInFlight, collector.maxErrors(), header, profile, output);
+
+	std::thread readerThread([&] {
+		placeThread(ThreadStage::Reader);
+		for (uint64_t index = 0;; ++index) {
+			{
+				std::unique_lock lock(state.mutex);
+				state.changed.wait(
+					lock, [&] { return state.cancelled || state.blocksRead - state.firstPending < maxInFlight; });
+				if (state.cancelled) {
+					break;
+				}
+			}
+
+			// The slot is free until the block is counted as read
+			BlockSlot &slot = state.slot(index);
+			if (!reader.next(slot.block)) {
+				break;
+			}
+
+			{
+				std::lock_guard lock(state.mutex);
+				slot.result.done = false;
+				++state.blocksRead;
+				++state.outstanding;
+			}
+			// Captures small enough for std::function to store without allocating
+			pool.submit([&state, index] {
+				BlockSlot &slot = state.slot(index);
+				bool cancelled = false;
+				{
+					std::lock_guard lock(state.mutex);
+					cancelled = state.cancelled;
+				}
+				if (!cancelled) {
+					validateBlock(slot.block, state, slot.result);
+				}
+
+				std::lock_guard lock(state.mutex);
+				slot.result.done = true;
+				--state.outstanding;
+				state.changed.notify_all();
+			});
+		}
+
+		std::lock_guard lock(state.mutex);
+		state.readerDone = true;
+		state.changed.notify_all();
+	});
+
+	// Collect results in input order so errors come out exactly as the serial path would report them
+	bool valid = true;
+	uint64_t lineOffset = firstLine - 1;
+	RecordOrder order;
+	std::vector<uint64_t> rejected;
+	while (true) {
+		{
+			std::unique_lock lock(state.mutex);
+			state.changed.wait(lock, [&] {
+				bool const pending = state.firstPending < state.blocksRead;
+				return (pending && state.slot(state.firstPending).result.done) || (state.readerDone && !pending);
+			});
+			if (state.firstPending == state.blocksRead) {
+				break;
+			}
+		}
+
+		// Nobody else touches the oldest slot until it is released below
+		BlockSlot &slot = state.slot(state.firstPending);
+		BlockResult &result = slot.result;
+		order.merge(result.order.runs(), result.errors);
+		valid = valid && result.errors.empty();
+		bool more = collector.merge(result.errors, lineOffset);
+		if (output != nullptr) {
+			// The lines merge found out of order with the blocks before are rejected as well
+			rejected.assign(result.rejected.begin(), result.rejected.end());
+			for (ValidationError const &error : result.errors) {
+				rejected.push_back(error.line);
+			}
+			std::sort(rejected.begin(), rejected.end());
+			rejected.erase(std::unique(rejected.begin(), rejected.end()), rejected.end());
+			more = output->block(slot.block.text, result.lines, rejected);
+		}
+		lineOffset += result.lines;
+		{
+			std::lock_guard lock(state.mutex);
+			++state.firstPending;
+			state.cancelled = !more;
+		}
+		state.changed.notify_all();
+		if (!more) {
+			break;
+		}
+	}
+
+	readerThread.join();
+
+	std::unique_lock lock(state.mutex);
+	state.changed.wait(lock, [&] { return state.outstanding == 0; });
+	return valid;
+}
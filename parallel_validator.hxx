@@ -0,0 +1,22 @@
+#pragma once
+
+#include "validation_profile.hxx"
+
+#include <cstdint>
+
+class BlockReader;
+class ErrorCollector;
+class FilteredOutput;
+class HeaderModel;
+class ThreadPool;
+
+// Validates every block of the VCF body (the lines after the column header line) on the pool.
+// Errors reach collector in input order, numbered from firstLine, and validation stops once the collector's
+// limit is reached, like the serial path. Data lines are checked against header, which must not change meanwhile,
+// with the checks of profile.
+// With output, every block is handed to it in input order with the lines that failed, and validation carries on
+// to the end of the input past the collector's limit, only no more errors are reported; it stops if writing fails.
+// Returns false if any line was invalid.
+bool validateBodyParallel(BlockReader &reader, ThreadPool &pool, ErrorCollector &collector, uint64_t firstLine,
+	HeaderModel const *header = nullptr, ValidationProfile profile = ValidationProfile::Strict,
+	FilteredOutput *output = nullptr);
@@ -0,0 +1,100 @@
+#include "perfect_hash.hxx"
+
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <utility>
+
+void PerfectHashIndex::insert(std::string_view key, uint32_t value)
+{
+	using namespace perfect_hash_detail;
+	if (find(key) != npos) {
+		return;
+	}
+	keys.push_back({key, value});
+
+	// Keep the current table while it has room and the new key's slot is free
+	if (slots.size() >= keys.size() * 2) {
+		uint64_t const hash = hashKey(key, seed);
+		uint32_t const displacement = displacements[hash & (displacements.size() - 1)];
+		Slot &slot = slots[displacedSlot(hash, displacement, slots.size() - 1)];
+		if (slot.value == npos) {
+			slot = {key, value};
+			return;
+		}
+	}
+	rebuild();
+}
+
+void PerfectHashIndex::clear()
+{
+	seed = 0;
+	displacements.clear();
+	slots.clear();
+	keys.clear();
+}
+
+// Hash and displace: buckets are placed largest first, each with the first displacement that puts all of its keys
+// into free slots. With at least twice as many slots as keys that takes a few tries per bucket; a key set that
+// still does not fit, or two keys with the same hash, get a new seed and more room.
+void PerfectHashIndex::rebuild()
+{
+	using namespace perfect_hash_detail;
+	size_t slotCount = std::bit_ceil(keys.size() * 2);
+	size_t const bucketCount = std::bit_ceil(std::max<size_t>(keys.size() / 2, 1));
+	constexpr uint32_t maxDisplacement = 1 << 16;
+
+	std::vector<std::vector<std::pair<uint64_t, Slot>>> buckets;
+	std::vector<size_t> order(bucketCount);
+	std::vector<size_t> taken;
+	for (uint64_t nextSeed = 0;; ++nextSeed) {
+		buckets.assign(bucketCount, {});
+		for (auto const &key : keys) {
+			uint64_t const hash = hashKey(key.key, nextSeed);
+			buckets[hash & (bucketCount - 1)].push_back({hash, key});
+		}
+		for (size_t i = 0; i < bucketCount; ++i) {
+			order[i] = i;
+		}
+		std::ranges::stable_sort(order, std::greater {}, [&buckets](size_t b) { return buckets[b].size(); });
+
+		displacements.assign(bucketCount, 0);
+		slots.assign(slotCount, {});
+		size_t const mask = slotCount - 1;
+		bool placedAll = true;
+		for (size_t b : order) {
+			auto const &bucket = buckets[b];
+			if (bucket.empty()) {
+				break; // Sorted by size, the rest are empty too
+			}
+			uint32_t displacement = 0;
+			for (; displacement < maxDisplacement; ++displacement) {
+				taken.clear();
+				bool const fits = std::ranges::all_of(bucket, [&](auto const &entry) {
+					size_t const slot = displacedSlot(entry.first, displacement, mask);
+					if (slots[slot].value != npos || std::ranges::find(taken, slot) != taken.end()) {
+						return false;
+					}
+					taken.push_back(slot);
+					return true;
+				});
+				if (fits) {
+					break;
+				}
+			}
+			if (displacement == maxDisplacement) {
+				placedAll = false;
+				break;
+			}
+			displacements[b] = displacement;
+			for (size_t k = 0; k < bucket.size(); ++k) {
+				slots[taken[k]] = bucket[k].second;
+			}
+		}
+		if (placedAll) {
+			seed = nextSeed;
+			return;
+		}
+		slotCount *= 2;
+	}
+}
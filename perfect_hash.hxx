@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace perfect_hash_detail {
+
+inline uint64_t hashKey(std::string_view key, uint64_t seed)
+{
+	uint64_t hash = 0xcbf29ce484222325 ^ seed; // FNV-1a
+	for (char c : key) {
+		hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3;
+	}
+	return hash ^ (hash >> 31);
+}
+
+// Slot of a key hash for one displacement, the displacements of a bucket give independent-looking slots
+inline size_t displacedSlot(uint64_t hash, uint32_t displacement, size_t mask)
+{
+	uint64_t mixed = hash + displacement * 0x9e3779b97f4a7c15;
+	mixed = (mixed ^ (mixed >> 33)) * 0xff51afd7ed558ccd;
+	return static_cast<size_t>(mixed ^ (mixed >> 33)) & mask;
+}
+
+} // namespace perfect_hash_detail
+
+// Perfect hash from string keys to values, for lookups on the data line hot path: one string hash, one bucket
+// displacement and one key comparison. The key of a bucket picks its displacement, the displacement the slot.
+// Keys are views and must outlive the index.
+class PerfectHashIndex {
+public:
+	static constexpr uint32_t npos = UINT32_MAX;
+
+	// Keys already present keep their value. Keys that fit the current table are added in place, the table is
+	// rebuilt otherwise, so inserting n keys one by one costs amortized O(n).
+	void insert(std::string_view key, uint32_t value);
+	// Removes every key, keeping the tables' memory for the next ones
+	void clear();
+
+	uint32_t find(std::string_view key) const
+	{
+		using namespace perfect_hash_detail;
+		if (slots.empty()) {
+			return npos;
+		}
+		uint64_t const hash = hashKey(key, seed);
+		uint32_t const displacement = displacements[hash & (displacements.size() - 1)];
+		Slot const &slot = slots[displacedSlot(hash, displacement, slots.size() - 1)];
+		return slot.value != npos && slot.key == key ? slot.value : npos;
+	}
+
+	size_t size() const
+	{
+		return keys.size();
+	}
+
+private:
+	struct Slot {
+		std::string_view key;
+		uint32_t value = npos;
+	};
+
+	uint64_t seed = 0;
+	std::vector<uint32_t> displacements;
+	std::vector<Slot> slots;
+	std::vector<Slot> keys; // In insertion order, for rebuilds
+
+	void rebuild();
+};
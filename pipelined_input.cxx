@@ -0,0 +1,70 @@
+#include "pipelined_input.hxx"
+
+#include "thread_affinity.hxx"
+#include "validation_stats.hxx"
+
+#include <ios>
+
+PipelinedInput::PipelinedInput(std::streambuf &source, size_t slots, size_t slotSize)
+	: source(source)
+	, slotSize(slotSize)
+	, ring(slots)
+	, producer([this] {
+		placeThread(ThreadStage::Inflate);
+		produce();
+	})
+{
+}
+
+PipelinedInput::~PipelinedInput()
+{
+	ring.close();
+	producer.join();
+}
+
+void PipelinedInput::produce()
+{
+	while (Chunk *chunk = ring.beginPush()) {
+		if (!chunk->data) {
+			chunk->data = std::make_unique<char[]>(slotSize);
+		}
+		try {
+			// The sources piped here are decompressors
+			ScopedStageTimer timer(StatsStage::Decompress);
+			chunk->size = static_cast<size_t>(source.sgetn(chunk->data.get(), static_cast<std::streamsize>(slotSize)));
+		} catch (...) {
+			chunk->size = 0;
+			chunk->error = std::current_exception();
+		}
+		bool const last = chunk->size == 0;
+		ring.commitPush();
+		if (last) {
+			return;
+		}
+	}
+}
+
+PipelinedInput::int_type PipelinedInput::underflow()
+{
+	if (gptr() < egptr()) {
+		return traits_type::to_int_type(*gptr());
+	}
+	if (ended) {
+		return traits_type::eof();
+	}
+	if (holding) {
+		ring.pop();
+	}
+	Chunk &chunk = ring.front();
+	holding = true;
+	if (chunk.size == 0) {
+		ended = true;
+		if (chunk.error) {
+			// The stream turns this into badbit, as it would have reading source directly
+			std::rethrow_exception(chunk.error);
+		}
+		return traits_type::eof();
+	}
+	setg(chunk.data.get(), chunk.data.get(), chunk.data.get() + chunk.size);
+	return traits_type::to_int_type(*gptr());
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "spsc_ring.hxx"
+
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <streambuf>
+#include <thread>
+
+// Input stream buffer reading source on a thread of its own into a ring of slotSize buffers, so that the reader of
+// this buffer, splitting and validating lines, runs alongside whatever source does to produce them, such as
+// inflating a plain gzip stream, instead of taking turns with it. The get area points straight into the filled
+// buffer. Destroying it stops the producer after the read in progress.
+class PipelinedInput final : public std::streambuf {
+public:
+	PipelinedInput(std::streambuf &source, size_t slots, size_t slotSize);
+	~PipelinedInput() override;
+
+	PipelinedInput(PipelinedInput const &) = delete;
+	PipelinedInput &operator=(PipelinedInput const &) = delete;
+
+protected:
+	int_type underflow() override;
+
+private:
+	struct Chunk {
+		std::unique_ptr<char[]> data;
+		// 0 marks the end of the input
+		size_t size = 0;
+		// What source threw while filling this chunk, rethrown to the reader
+		std::exception_ptr error;
+	};
+
+	void produce();
+
+	std::streambuf &source;
+	size_t slotSize;
+	SpscRing<Chunk> ring;
+	// The front chunk of the ring is the get area
+	bool holding = false;
+	bool ended = false;
+	// Last, so that it starts once everything it uses is constructed
+	std::thread producer;
+};
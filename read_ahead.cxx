@@ -0,0 +1,480 @@
+#include "read_ahead.hxx"
+
+#include "thread_affinity.hxx"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <ios>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#	include <linux/io_uring.h>
+#	include <sys/mman.h>
+#	include <sys/syscall.h>
+#	define GENOMIC_VALIDATOR_IO_URING 1
+#endif
+
+namespace read_ahead_detail {
+
+// Reads with a tag that comes back with their completion
+class ReadBackend {
+public:
+	virtual ~ReadBackend() = default;
+
+	virtual std::string_view name() const = 0;
+	virtual void submit(int fd, char *buffer, size_t size, uint64_t offset, size_t tag) = 0;
+	// Waits for a read to complete, returns its tag and the bytes read or -errno
+	virtual std::pair<size_t, int64_t> wait() = 0;
+};
+
+} // namespace read_ahead_detail
+
+namespace {
+
+using read_ahead_detail::ReadBackend;
+
+// pread on a few threads, for systems without io_uring or where it is disabled
+class ThreadBackend final : public ReadBackend {
+public:
+	explicit ThreadBackend(size_t threadCount)
+	{
+		for (size_t i = 0; i < threadCount; ++i) {
+			threads.emplace_back([this] {
+				placeThread(ThreadStage::Reader);
+				workerLoop();
+			});
+		}
+	}
+
+	~ThreadBackend() override
+	{
+		{
+			std::lock_guard lock(mutex);
+			stopping = true;
+		}
+		requestAdded.notify_all();
+		for (auto &thread : threads) {
+			thread.join();
+		}
+	}
+
+	std::string_view name() const override
+	{
+		return "threads";
+	}
+
+	void submit(int fd, char *buffer, size_t size, uint64_t offset, size_t tag) override
+	{
+		{
+			std::lock_guard lock(mutex);
+			requests.push_back({fd, buffer, size, offset, tag});
+		}
+		requestAdded.notify_one();
+	}
+
+	std::pair<size_t, int64_t> wait() override
+	{
+		std::unique_lock lock(mutex);
+		readDone.wait(lock, [this] { return !completions.empty(); });
+		auto const completion = completions.front();
+		completions.pop_front();
+		return completion;
+	}
+
+private:
+	struct Request {
+		int fd;
+		char *buffer;
+		size_t size;
+		uint64_t offset;
+		size_t tag;
+	};
+
+	void workerLoop()
+	{
+		while (true) {
+			Request request {};
+			{
+				std::unique_lock lock(mutex);
+				requestAdded.wait(lock, [this] { return stopping || !requests.empty(); });
+				if (requests.empty()) {
+					return;
+				}
+				request = requests.front();
+				requests.pop_front();
+			}
+
+			ssize_t result = 0;
+			do {
+				result = ::pread(request.fd, request.buffer, request.size, static_cast<off_t>(request.offset));
+			} while (result < 0 && errno == EINTR);
+			int64_t const outcome = result < 0 ? -static_cast<int64_t>(errno) : result;
+
+			{
+				std::lock_guard lock(mutex);
+				completions.emplace_back(request.tag, outcome);
+			}
+			readDone.notify_one();
+		}
+	}
+
+	std::mutex mutex;
+	std::condition_variable requestAdded;
+	std::condition_variable readDone;
+	std::deque<Request> requests;
+	std::deque<std::pair<size_t, int64_t>> completions;
+	bool stopping = false;
+	std::vector<std::thread> threads;
+};
+
+#if defined(GENOMIC_VALIDATOR_IO_URING)
+
+// One io_uring instance driven through the raw system calls, so no liburing is needed. Only the thread owning
+// the ReadAheadBuffer submits and reaps, which keeps the ring handling single-producer on both sides.
+class IoUringBackend final : public ReadBackend {
+public:
+	// Null when the kernel has no io_uring with IORING_OP_READ, or it is not permitted
+	static std::unique_ptr<IoUringBackend> create(unsigned entries)
+	{
+		io_uring_params params {};
+		int const fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+		if (fd < 0) {
+			return nullptr;
+		}
+		// IORING_OP_READ came with the same kernel as IORING_FEAT_RW_CUR_POS
+		if ((params.features & IORING_FEAT_RW_CUR_POS) == 0) {
+			::close(fd);
+			return nullptr;
+		}
+		auto backend = std::unique_ptr<IoUringBackend>(new IoUringBackend(fd, params));
+		if (backend->sqes == nullptr) {
+			return nullptr;
+		}
+		return backend;
+	}
+
+	~IoUringBackend() override
+	{
+		if (sqes != nullptr) {
+			::munmap(sqes, sqesSize);
+		}
+		if (cqRing != nullptr && cqRing != sqRing) {
+			::munmap(cqRing, cqRingSize);
+		}
+		if (sqRing != nullptr) {
+			::munmap(sqRing, sqRingSize);
+		}
+		::close(ringFd);
+	}
+
+	std::string_view name() const override
+	{
+		return "io_uring";
+	}
+
+	void submit(int fd, char *buffer, size_t size, uint64_t offset, size_t tag) override
+	{
+		std::atomic_ref<uint32_t> tail(*sqTail);
+		uint32_t const current = tail.load(std::memory_order_relaxed);
+		uint32_t const index = current & sqMask;
+		io_uring_sqe &sqe = sqes[index];
+		std::memset(&sqe, 0, sizeof(sqe));
+		sqe.opcode = IORING_OP_READ;
+		sqe.fd = fd;
+		sqe.addr = reinterpret_cast<uint64_t>(buffer);
+		sqe.len = static_cast<uint32_t>(size);
+		sqe.off = offset;
+		sqe.user_data = tag;
+		sqArray[index] = index;
+		tail.store(current + 1, std::memory_order_release);
+
+		while (enter(1, 0, 0) < 0) {
+			if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+				throw std::system_error(errno, std::system_category(), "io_uring_enter");
+			}
+		}
+	}
+
+	std::pair<size_t, int64_t> wait() override
+	{
+		std::atomic_ref<uint32_t> head(*cqHead);
+		std::atomic_ref<uint32_t> tail(*cqTail);
+		while (true) {
+			uint32_t const current = head.load(std::memory_order_relaxed);
+			if (current != tail.load(std::memory_order_acquire)) {
+				io_uring_cqe const &cqe = cqes[current & cqMask];
+				std::pair<size_t, int64_t> const completion(static_cast<size_t>(cqe.user_data), cqe.res);
+				head.store(current + 1, std::memory_order_release);
+				return completion;
+			}
+			if (enter(0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+				throw std::system_error(errno, std::system_category(), "io_uring_enter");
+			}
+		}
+	}
+
+private:
+	IoUringBackend(int fd, io_uring_params const &params)
+		: ringFd(fd)
+	{
+		sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+		cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+		bool const singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+		if (singleMap) {
+			sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+		}
+
+		sqRing = map(sqRingSize, IORING_OFF_SQ_RING);
+		if (sqRing == nullptr) {
+			return;
+		}
+		cqRing = singleMap ? sqRing : map(cqRingSize, IORING_OFF_CQ_RING);
+		if (cqRing == nullptr) {
+			return;
+		}
+		sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+		auto *const entries = static_cast<io_uring_sqe *>(map(sqesSize, IORING_OFF_SQES));
+		if (entries == nullptr) {
+			return;
+		}
+
+		auto *const sq = static_cast<char *>(sqRing);
+		auto *const cq = static_cast<char *>(cqRing);
+		sqTail = reinterpret_cast<uint32_t *>(sq + params.sq_off.tail);
+		sqMask = *reinterpret_cast<uint32_t const *>(sq + params.sq_off.ring_mask);
+		sqArray = reinterpret_cast<uint32_t *>(sq + params.sq_off.array);
+		cqHead = reinterpret_cast<uint32_t *>(cq + params.cq_off.head);
+		cqTail = reinterpret_cast<uint32_t *>(cq + params.cq_off.tail);
+		cqMask = *reinterpret_cast<uint32_t const *>(cq + params.cq_off.ring_mask);
+		cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+		sqes = entries;
+	}
+
+	void *map(size_t size, off_t offset) const
+	{
+		void *const memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, offset);
+		return memory != MAP_FAILED ? memory : nullptr;
+	}
+
+	int enter(unsigned toSubmit, unsigned minComplete, unsigned flags) const
+	{
+		return static_cast<int>(::syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0));
+	}
+
+	int ringFd;
+	void *sqRing = nullptr;
+	void *cqRing = nullptr;
+	size_t sqRingSize = 0;
+	size_t cqRingSize = 0;
+	size_t sqesSize = 0;
+	io_uring_sqe *sqes = nullptr;
+	uint32_t *sqTail = nullptr;
+	uint32_t *sqArray = nullptr;
+	uint32_t sqMask = 0;
+	uint32_t *cqHead = nullptr;
+	uint32_t *cqTail = nullptr;
+	uint32_t cqMask = 0;
+	io_uring_cqe *cqes = nullptr;
+};
+
+#endif
+
+// A single read is limited to what io_uring and pread can report
+constexpr size_t maxBlockSize = size_t {1} << 30;
+
+} // namespace
+
+ReadAheadBuffer::ReadAheadBuffer(std::string const &fileName, size_t depth, size_t blockSize, bool preferThreads)
+	: blockSize(std::clamp<size_t>(blockSize, 4096, maxBlockSize))
+{
+	fd = ::open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return;
+	}
+	::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+	depth = std::max<size_t>(depth, 1);
+#if defined(GENOMIC_VALIDATOR_IO_URING)
+	if (!preferThreads) {
+		backend = IoUringBackend::create(static_cast<unsigned>(depth));
+	}
+#endif
+	if (backend == nullptr) {
+		backend = std::make_unique<ThreadBackend>(depth);
+	}
+
+	slots.resize(depth);
+	for (Slot &slot : slots) {
+		slot.data = std::make_unique_for_overwrite<char[]>(this->blockSize);
+	}
+	restart(0);
+}
+
+ReadAheadBuffer::~ReadAheadBuffer()
+{
+	if (fd < 0) {
+		return;
+	}
+	drain();
+	::close(fd);
+}
+
+std::string_view ReadAheadBuffer::backendName() const
+{
+	return backend != nullptr ? backend->name() : std::string_view();
+}
+
+void ReadAheadBuffer::restart(uint64_t offset)
+{
+	drain();
+	setg(nullptr, nullptr, nullptr);
+	nextOffset = offset;
+	endSeen = false;
+	head = 0;
+	headInUse = false;
+	for (size_t i = 0; i < slots.size(); ++i) {
+		submit(i);
+	}
+}
+
+void ReadAheadBuffer::submit(size_t index)
+{
+	Slot &slot = slots[index];
+	slot.offset = nextOffset;
+	nextOffset += blockSize;
+	slot.filled = 0;
+	slot.error = 0;
+	slot.complete = endSeen;
+	if (!endSeen) {
+		backend->submit(fd, slot.data.get(), blockSize, slot.offset, index);
+		++inFlight;
+	}
+}
+
+void ReadAheadBuffer::waitFor(size_t index)
+{
+	while (!slots[index].complete) {
+		auto const [tag, result] = backend->wait();
+		--inFlight;
+		Slot &slot = slots[tag];
+		if (result == -EINTR || result == -EAGAIN) {
+			// Retried below like a short read
+		} else if (result < 0) {
+			slot.error = static_cast<int>(-result);
+			slot.complete = true;
+			continue;
+		} else if (result == 0) {
+			// Nothing at this offset, so every block after it is past the end too
+			endSeen = true;
+			slot.complete = true;
+			continue;
+		} else {
+			slot.filled += static_cast<size_t>(result);
+			if (slot.filled == blockSize) {
+				slot.complete = true;
+				continue;
+			}
+		}
+		// Short read, ask for the rest of the block
+		backend->submit(fd, slot.data.get() + slot.filled, blockSize - slot.filled, slot.offset + slot.filled, tag);
+		++inFlight;
+	}
+}
+
+void ReadAheadBuffer::drain()
+{
+	while (inFlight != 0) {
+		backend->wait();
+		--inFlight;
+	}
+}
+
+uint64_t ReadAheadBuffer::position() const
+{
+	Slot const &slot = slots[head];
+	return slot.offset + (headInUse ? static_cast<uint64_t>(gptr() - eback()) : 0);
+}
+
+ReadAheadBuffer::int_type ReadAheadBuffer::underflow()
+{
+	if (gptr() < egptr()) {
+		return traits_type::to_int_type(*gptr());
+	}
+	if (fd < 0) {
+		return traits_type::eof();
+	}
+	if (headInUse) {
+		// A block that came back short ends the file
+		if (slots[head].filled < blockSize) {
+			return traits_type::eof();
+		}
+		submit(head);
+		head = (head + 1) % slots.size();
+		headInUse = false;
+	}
+
+	waitFor(head);
+	Slot &slot = slots[head];
+	headInUse = true;
+	setg(slot.data.get(), slot.data.get(), slot.data.get() + slot.filled);
+	if (slot.error != 0) {
+		// The stream turns this into badbit, like a failed read of a std::ifstream
+		throw std::ios_base::failure("read", std::error_code(slot.error, std::system_category()));
+	}
+	if (blockObserver && slot.filled != 0) {
+		blockObserver(slot.offset, {slot.data.get(), slot.filled});
+	}
+	return slot.filled != 0 ? traits_type::to_int_type(*gptr()) : traits_type::eof();
+}
+
+ReadAheadBuffer::pos_type ReadAheadBuffer::seekoff(
+	off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode which)
+{
+	if (fd < 0 || (which & std::ios_base::in) == 0) {
+		return pos_type(off_type(-1));
+	}
+	off_type base = 0;
+	if (direction == std::ios_base::cur) {
+		if (offset == 0) {
+			return pos_type(static_cast<off_type>(position())); // tellg
+		}
+		base = static_cast<off_type>(position());
+	} else if (direction == std::ios_base::end) {
+		struct stat status {};
+		if (::fstat(fd, &status) != 0) {
+			return pos_type(off_type(-1));
+		}
+		base = static_cast<off_type>(status.st_size);
+	}
+	if (base + offset < 0) {
+		return pos_type(off_type(-1));
+	}
+	auto const target = static_cast<uint64_t>(base + offset);
+
+	// Within the block at hand, as when a format check peeks at the first bytes and seeks back
+	if (headInUse) {
+		Slot const &slot = slots[head];
+		if (target >= slot.offset && target <= slot.offset + slot.filled) {
+			setg(eback(), eback() + (target - slot.offset), egptr());
+			return pos_type(static_cast<off_type>(target));
+		}
+	}
+	restart(target);
+	return pos_type(static_cast<off_type>(target));
+}
+
+ReadAheadBuffer::pos_type ReadAheadBuffer::seekpos(pos_type position, std::ios_base::openmode which)
+{
+	return seekoff(off_type(position), std::ios_base::beg, which);
+}
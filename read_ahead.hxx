@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace read_ahead_detail {
+class ReadBackend;
+}
+
+// Input stream buffer reading a file in blockSize pieces with up to depth reads in flight ahead of the consumer, so
+// that a decompressor reading from network storage does not wait out the latency of every refill. The reads go
+// through io_uring where the kernel offers it and to a pool of pread threads elsewhere; the get area points
+// straight into the completed block. Seeking restarts the reads at the new position.
+class ReadAheadBuffer final : public std::streambuf {
+public:
+	// preferThreads skips io_uring
+	ReadAheadBuffer(std::string const &fileName, size_t depth, size_t blockSize, bool preferThreads = false);
+	~ReadAheadBuffer() override;
+
+	ReadAheadBuffer(ReadAheadBuffer const &) = delete;
+	ReadAheadBuffer &operator=(ReadAheadBuffer const &) = delete;
+
+	bool isOpen() const
+	{
+		return fd >= 0;
+	}
+	// "io_uring" or "threads"
+	std::string_view backendName() const;
+	// Called with the offset and bytes of every block as it is handed to the consumer, such as for hashing the
+	// input in the same pass (ContentHash)
+	void setBlockObserver(std::function<void(uint64_t, std::string_view)> observer)
+	{
+		blockObserver = std::move(observer);
+	}
+
+protected:
+	int_type underflow() override;
+	pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode which) override;
+	pos_type seekpos(pos_type position, std::ios_base::openmode which) override;
+
+private:
+	struct Slot {
+		std::unique_ptr<char[]> data;
+		uint64_t offset = 0;
+		size_t filled = 0;
+		bool complete = false;
+		// Errno of a failed read, 0 if none
+		int error = 0;
+	};
+
+	void restart(uint64_t offset);
+	void submit(size_t index);
+	void waitFor(size_t index);
+	// Waits until no read is in flight, before the buffers are reused or freed
+	void drain();
+	uint64_t position() const;
+
+	int fd = -1;
+	size_t blockSize;
+	std::unique_ptr<read_ahead_detail::ReadBackend> backend;
+	std::vector<Slot> slots;
+	// slots[head] is the block in the get area, the others follow it in file order
+	size_t head = 0;
+	bool headInUse = false;
+	uint64_t nextOffset = 0;
+	// A read came back empty: the blocks from there on are past the end of the file
+	bool endSeen = false;
+	size_t inFlight = 0;
+	std::function<void(uint64_t, std::string_view)> blockObserver;
+};
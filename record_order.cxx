@@ -0,0 +1,108 @@
+#include "record_order.hxx"
+
+#include "error_sink.hxx"
+
+#include <algorithm>
+#include <charconv>
+#include <utility>
+
+namespace {
+
+void reportUnsorted(uint64_t pos)
+{
+	char text[20];
+	auto const [end, ec] = std::to_chars(std::begin(text), std::end(text), pos);
+	reportError(ErrorCode::UnsortedPos, std::string_view(text, end));
+}
+
+// Puts the error reported by report for line into errors, in line order
+template<typename Report>
+void insertError(std::vector<ValidationError> &errors, uint64_t line, Report &&report)
+{
+	ErrorSink sink(1);
+	{
+		ErrorSinkScope scope(sink);
+		sink.setLine(line);
+		report();
+	}
+	auto const at = std::ranges::lower_bound(errors, line, {}, &ValidationError::line);
+	if (at != errors.end() && at->line == line) {
+		*at = sink.errors().front();
+	} else {
+		errors.insert(at, sink.errors().front());
+	}
+}
+
+// Runs searched directly before looking contigs up in a set pays off
+constexpr size_t maxSearchedRuns = 16;
+
+} // namespace
+
+bool RecordOrder::seenBefore(std::string_view chrom) const
+{
+	if (seen.empty()) {
+		return std::ranges::any_of(contigRuns, [chrom](ContigRun const &run) { return run.contig == chrom; });
+	}
+	return seen.contains(chrom);
+}
+
+void RecordOrder::addRun(ContigRun run)
+{
+	contigRuns.push_back(std::move(run));
+	if (!seen.empty()) {
+		seen.insert(contigRuns.back().contig);
+	} else if (contigRuns.size() > maxSearchedRuns) {
+		for (ContigRun const &each : contigRuns) {
+			seen.insert(each.contig);
+		}
+	}
+}
+
+void RecordOrder::clear()
+{
+	contigRuns.clear();
+	seen.clear();
+	currentLine = 0;
+}
+
+bool RecordOrder::check(std::string_view chrom, uint64_t pos)
+{
+	if (!contigRuns.empty() && contigRuns.back().contig == chrom) {
+		ContigRun &run = contigRuns.back();
+		bool const sorted = pos >= run.lastPos;
+		run.lastPos = pos;
+		if (!sorted) {
+			reportUnsorted(pos);
+		}
+		return sorted;
+	}
+
+	bool const contiguous = !seenBefore(chrom);
+	addRun({std::string(chrom), currentLine, pos, pos});
+	if (!contiguous) {
+		reportError(ErrorCode::NonContiguousContig, chrom);
+	}
+	return contiguous;
+}
+
+void RecordOrder::merge(std::span<ContigRun const> next, std::vector<ValidationError> &errors)
+{
+	for (size_t i = 0; i < next.size(); ++i) {
+		ContigRun const &run = next[i];
+		if (i == 0 && !contigRuns.empty() && contigRuns.back().contig == run.contig) {
+			if (run.firstPos < contigRuns.back().lastPos) {
+				insertError(errors, run.firstLine, [&run] { reportUnsorted(run.firstPos); });
+			}
+			contigRuns.back().lastPos = run.lastPos;
+			continue;
+		}
+
+		// A contig coming back within next was reported there already
+		bool const reportedInNext = std::ranges::any_of(
+			next.first(i), [&run](ContigRun const &earlier) { return earlier.contig == run.contig; });
+		if (!reportedInNext && seenBefore(run.contig)) {
+			insertError(errors, run.firstLine, [&run] { reportError(ErrorCode::NonContiguousContig, run.contig); });
+		}
+		addRun(run);
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <set>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct ValidationError;
+
+// Consecutive records on one contig
+struct ContigRun {
+	std::string contig;
+	uint64_t firstLine = 0;
+	uint64_t firstPos = 0;
+	uint64_t lastPos = 0;
+};
+
+// Sorted-order checks over a stretch of data lines: POS must not decrease within a contig, and the records of a
+// contig must be contiguous. Stretches validated on their own (blocks on worker threads) are joined with merge(),
+// which checks where they meet, so the result is the same as checking the whole input in one pass.
+class RecordOrder {
+public:
+	// Line number of the records checked from now on
+	void setLine(uint64_t line)
+	{
+		currentLine = line;
+	}
+	// Reports and returns false when the record at chrom:pos is out of order
+	bool check(std::string_view chrom, uint64_t pos);
+
+	std::span<ContigRun const> runs() const
+	{
+		return contigRuns;
+	}
+
+	// Forgets every record checked so far, keeping the memory for the next stretch
+	void clear();
+
+	// Continues this stretch with the runs of the one right after it. Where they meet out of order an error is added
+	// to errors, the later stretch's errors numbered like its runs, sorted by line with at most one per line. The
+	// error replaces one the later stretch found further along the same line, like check() would have.
+	void merge(std::span<ContigRun const> next, std::vector<ValidationError> &errors);
+
+private:
+	bool seenBefore(std::string_view chrom) const;
+	void addRun(ContigRun run);
+
+	std::vector<ContigRun> contigRuns;
+	// Contigs of contigRuns, only kept once there are too many runs to search them, so that the short stretches of
+	// the worker threads do not allocate set nodes
+	std::set<std::string, std::less<>> seen;
+	uint64_t currentLine = 0;
+};
@@ -0,0 +1,264 @@
+#include "region_validator.hxx"
+
+#include "bgzf_reader.hxx"
+#include "error_sink.hxx"
+#include "record_order.hxx"
+#include "tabix_index.hxx"
+#include "thread_pool.hxx"
+#include "validation_stats.hxx"
+#include "vcf_validation.hxx"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <exception>
+#include <fstream>
+#include <future>
+#include <ostream>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+bool parsePosition(std::string_view text, uint64_t &value)
+{
+	auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+	return ec == std::errc() && ptr == text.data() + text.size();
+}
+
+struct RegionResult {
+	std::vector<ValidationError> errors;
+	std::exception_ptr failure;
+};
+
+// Errors per task buffered before they are moved into the region's result
+constexpr size_t regionSinkCapacity = 64;
+
+enum class Placement
+{
+	Before, // Ends before the region, or belongs to another contig
+	Inside, // Overlaps the region, or cannot be placed and has to be validated to report why
+	After,
+};
+
+// Where the record on line lies relative to region, by its CHROM, POS and the length of REF
+Placement placeRecord(std::string_view line, Region const &region)
+{
+	auto const chromEnd = line.find('\t');
+	if (chromEnd == std::string_view::npos) {
+		return Placement::Inside;
+	}
+	if (line.substr(0, chromEnd) != region.contig) {
+		return Placement::Before;
+	}
+	auto const posEnd = line.find('\t', chromEnd + 1);
+	uint64_t pos = 0;
+	if (posEnd == std::string_view::npos || !parsePosition(line.substr(chromEnd + 1, posEnd - chromEnd - 1), pos)
+		|| pos == 0) {
+		return Placement::Inside;
+	}
+	if (pos - 1 >= region.end) {
+		return Placement::After;
+	}
+	auto const idEnd = line.find('\t', posEnd + 1);
+	auto const refEnd = idEnd != std::string_view::npos ? line.find('\t', idEnd + 1) : std::string_view::npos;
+	size_t const refLength = refEnd != std::string_view::npos ? std::max<size_t>(refEnd - idEnd - 1, 1) : 1;
+	return pos - 1 + refLength <= region.begin ? Placement::Before : Placement::Inside;
+}
+
+// Validates the records of one region; stops after maxErrors invalid lines, or once an earlier region has reached
+// that many, since the collector will not take any of this region's errors then
+void validateRegion(std::string const &fileName, TabixIndex const &index, Region const &region, size_t regionIndex,
+	size_t maxErrors, std::atomic<size_t> &firstExhausted, HeaderModel const *header, ValidationProfile profile,
+	RegionResult &result)
+{
+	std::ifstream file(fileName, std::ios_base::in | std::ios_base::binary);
+	if (!file.is_open()) {
+		throw std::runtime_error("Failed to open file");
+	}
+	BgzfCursor cursor(file);
+	ErrorSink sink(regionSinkCapacity);
+	ErrorSinkScope scope(sink);
+	// Sorted order is only checked within the region, the records between regions are never read
+	RecordOrder order;
+	auto const keepErrors = [&] {
+		result.errors.insert(result.errors.end(), sink.errors().begin(), sink.errors().end());
+		sink.clear();
+	};
+
+	size_t failedLines = 0;
+	std::string line;
+	for (auto const &chunk : index.query(region.contig, region.begin, region.end)) {
+		cursor.seek(chunk.begin);
+		while (cursor.tell() < chunk.end && cursor.readLine(line)) {
+			countStats(StatsCounter::Bytes, line.size() + 1);
+			if (firstExhausted.load(std::memory_order_relaxed) < regionIndex) {
+				return;
+			}
+
+			// Chunks can hold records outside the region
+			Placement const placement = placeRecord(line, region);
+			if (placement == Placement::Before) {
+				continue;
+			}
+			if (placement == Placement::After) {
+				keepErrors();
+				return; // Records are sorted, nothing later overlaps
+			}
+
+			if (validateBodyLine(line, header, &order, profile)) {
+				continue;
+			}
+			if (sink.full()) {
+				keepErrors();
+			}
+			if (++failedLines == maxErrors) {
+				size_t expected = firstExhausted.load();
+				while (regionIndex < expected && !firstExhausted.compare_exchange_weak(expected, regionIndex)) {
+				}
+				keepErrors();
+				return;
+			}
+		}
+	}
+	keepErrors();
+}
+
+// Sorts regions into index order and merges overlapping ones of the same contig
+std::vector<Region> normalizeRegions(TabixIndex const &index, std::vector<Region> regions)
+{
+	auto const order = [&index](Region const &region) {
+		auto const &contigs = index.contigs();
+		return static_cast<size_t>(std::ranges::find(contigs, region.contig) - contigs.begin());
+	};
+	std::ranges::stable_sort(regions, [&](Region const &a, Region const &b) {
+		return std::pair(order(a), a.begin) < std::pair(order(b), b.begin);
+	});
+	std::vector<Region> merged;
+	for (auto &region : regions) {
+		if (!merged.empty() && merged.back().contig == region.contig && region.begin <= merged.back().end) {
+			merged.back().end = std::max(merged.back().end, region.end);
+		} else {
+			merged.push_back(std::move(region));
+		}
+	}
+	return merged;
+}
+
+} // namespace
+
+bool parseRegion(std::string_view text, Region &region)
+{
+	region = Region {};
+	auto const colon = text.rfind(':');
+	if (colon == std::string_view::npos) {
+		region.contig = text;
+		return !text.empty();
+	}
+	region.contig = text.substr(0, colon);
+	std::string_view const range = text.substr(colon + 1);
+	auto const dash = range.find('-');
+	uint64_t start = 0;
+	if (!parsePosition(range.substr(0, dash), start) || start == 0) {
+		return false;
+	}
+	region.begin = start - 1;
+	if (dash != std::string_view::npos && dash + 1 < range.size()) {
+		uint64_t end = 0;
+		if (!parsePosition(range.substr(dash + 1), end) || end < start) {
+			return false;
+		}
+		region.end = end;
+	}
+	return !region.contig.empty();
+}
+
+bool readRegionsFile(std::string const &path, std::vector<Region> &regions)
+{
+	std::ifstream file(path);
+	if (!file.is_open()) {
+		diagnostics() << "Failed to open file: " << path << '\n';
+		return false;
+	}
+	bool const bed = path.ends_with(".bed");
+	std::string line;
+	while (std::getline(file, line)) {
+		if (line.empty() || line.starts_with('#') || line.starts_with("track") || line.starts_with("browser")) {
+			continue;
+		}
+
+		Region region;
+		auto const tab = line.find('\t');
+		bool valid = false;
+		if (tab == std::string::npos) {
+			valid = parseRegion(line, region);
+		} else {
+			std::string_view const view = line;
+			auto const secondTab = view.find('\t', tab + 1);
+			auto const thirdTab = view.find('\t', secondTab + 1);
+			uint64_t start = 0;
+			uint64_t end = 0;
+			region.contig = view.substr(0, tab);
+			valid = secondTab != std::string_view::npos
+				&& parsePosition(view.substr(tab + 1, secondTab - tab - 1), start)
+				&& parsePosition(view.substr(secondTab + 1, thirdTab - secondTab - 1), end)
+				&& (bed ? start <= end : start != 0 && start <= end);
+			region.begin = bed ? start : start - 1;
+			region.end = end;
+		}
+		if (!valid) {
+			diagnostics() << "Invalid region: " << line << '\n';
+			return false;
+		}
+		regions.push_back(std::move(region));
+	}
+	return true;
+}
+
+bool validateRegions(std::string const &fileName, TabixIndex const &index, std::vector<Region> regions,
+	ErrorCollector &collector, ThreadPool *pool, HeaderModel const *header, ValidationProfile profile)
+{
+	for (auto const &region : regions) {
+		if (!index.hasContig(region.contig)) {
+			diagnostics() << "Contig not in index: " << region.contig << '\n';
+			return false;
+		}
+	}
+	regions = normalizeRegions(index, std::move(regions));
+
+	size_t const maxErrors = collector.maxErrors();
+	std::atomic<size_t> firstExhausted = SIZE_MAX;
+	std::vector<RegionResult> results(regions.size());
+	std::vector<std::future<void>> done;
+	done.reserve(regions.size());
+	for (size_t i = 0; i < regions.size(); ++i) {
+		auto task = std::make_shared<std::packaged_task<void()>>([&, i] {
+			validateRegion(fileName, index, regions[i], i, maxErrors, firstExhausted, header, profile, results[i]);
+		});
+		done.push_back(task->get_future());
+		if (pool != nullptr) {
+			pool->submit([task] { (*task)(); });
+		} else {
+			(*task)();
+		}
+	}
+
+	// Wait for every task before returning, they reference the locals above
+	bool readable = true;
+	for (size_t i = 0; i < regions.size(); ++i) {
+		try {
+			done[i].get();
+		} catch (std::exception const &e) {
+			if (readable) {
+				collector.flush();
+				diagnostics() << "Failed to read or decompress file: " << fileName << ": " << e.what() << '\n';
+			}
+			readable = false;
+		}
+		if (readable && !collector.limitReached()) {
+			collector.merge(results[i].errors, 0);
+		}
+	}
+	return readable && collector.errorCount() == 0;
+}
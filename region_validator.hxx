@@ -0,0 +1,36 @@
+#pragma once
+
+#include "validation_profile.hxx"
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class ErrorCollector;
+class HeaderModel;
+class TabixIndex;
+class ThreadPool;
+
+// 0-based half-open range of one contig
+struct Region {
+	std::string contig;
+	uint64_t begin = 0;
+	uint64_t end = UINT64_MAX;
+};
+
+// Parses "chr", "chr:start" or "chr:start-end" with 1-based inclusive positions
+bool parseRegion(std::string_view text, Region &region);
+// Appends the regions of a file with one region per line, either in parseRegion() form or as tab-separated
+// "chr start end" (1-based inclusive, or 0-based half-open for .bed files). Prints a message and returns false on
+// an unreadable file or a malformed line.
+bool readRegionsFile(std::string const &path, std::vector<Region> &regions);
+
+// Validates the data lines of a BGZF-compressed VCF overlapping regions, reading only the chunks index points at.
+// Regions are sorted into index order and merged first; with a pool every region is validated as its own task.
+// Errors reach collector in region order, without line numbers since the lines before a region are never read.
+// Data lines are checked against header, with the checks of profile. Returns false if a line was invalid or the file could not be read.
+bool validateRegions(std::string const &fileName, TabixIndex const &index, std::vector<Region> regions,
+	ErrorCollector &collector, ThreadPool *pool, HeaderModel const *header = nullptr,
+	ValidationProfile profile = ValidationProfile::Strict);
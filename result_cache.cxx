@@ -0,0 +1,133 @@
+#include "result_cache.hxx"
+
+#include "content_hash.hxx"
+
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <ios>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#include <sys/stat.h>
+
+#include <fmt/format.h>
+
+// An entry is a few lines of text followed by the messages verbatim:
+//   gvcache 1
+//   path <canonical path>
+//   identity <device> <inode> <size> <modified>
+//   hash <content hash> <bytes hashed>
+//   valid <0 or 1>
+//   messages <size in bytes>
+//   <messages>
+// The path guards against two files whose paths hash alike.
+namespace {
+
+constexpr std::string_view magic = "gvcache 2";
+
+} // namespace
+
+bool fileIdentity(std::string const &fileName, FileIdentity &identity)
+{
+	struct stat status {};
+	if (::stat(fileName.c_str(), &status) != 0) {
+		return false;
+	}
+	identity.device = status.st_dev;
+	identity.inode = status.st_ino;
+	identity.size = static_cast<uint64_t>(status.st_size);
+	identity.modified = static_cast<uint64_t>(status.st_mtim.tv_sec) * 1000000000 + status.st_mtim.tv_nsec;
+	return true;
+}
+
+ResultCache::ResultCache(std::string directory, std::string_view settings)
+	: directory(std::move(directory))
+{
+	Xxh64 hash;
+	hash.update(settings);
+	settingsHash = hash.digest();
+}
+
+std::string ResultCache::entryPath(std::string const &fileName, std::string &canonical) const
+{
+	std::error_code error;
+	auto path = std::filesystem::weakly_canonical(fileName, error);
+	if (error) {
+		path = std::filesystem::absolute(fileName);
+	}
+	canonical = path.string();
+	Xxh64 hash(settingsHash);
+	hash.update(canonical);
+	return fmt::format("{}/{:016x}.result", directory, hash.digest());
+}
+
+bool ResultCache::lookup(std::string const &fileName, CachedResult &result) const
+{
+	std::string canonical;
+	std::ifstream in(entryPath(fileName, canonical), std::ios_base::in | std::ios_base::binary);
+	std::string line;
+	if (!in.is_open() || !std::getline(in, line) || line != magic || !std::getline(in, line)
+		|| line != "path " + canonical) {
+		return false;
+	}
+
+	CachedResult read;
+	std::string key;
+	size_t messagesSize = 0;
+	in >> key >> read.identity.device >> read.identity.inode >> read.identity.size >> read.identity.modified;
+	if (key != "identity") {
+		return false;
+	}
+	in >> key >> std::hex >> read.contentHash >> std::dec >> read.hashedSize;
+	if (key != "hash") {
+		return false;
+	}
+	in >> key >> read.valid;
+	if (key != "valid") {
+		return false;
+	}
+	in >> key >> messagesSize;
+	if (key != "messages" || in.get() != '\n') {
+		return false;
+	}
+	read.messages.resize(messagesSize);
+	if (!in.read(read.messages.data(), static_cast<std::streamsize>(messagesSize))) {
+		return false;
+	}
+	result = std::move(read);
+	return true;
+}
+
+bool ResultCache::store(std::string const &fileName, CachedResult const &result) const
+{
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+	std::string canonical;
+	std::string const path = entryPath(fileName, canonical);
+	// Unique per thread, so that validations of the same file in one batch do not write over each other's
+	std::string const temporary
+		= fmt::format("{}.{:x}.tmp", path, std::hash<std::thread::id> {}(std::this_thread::get_id()));
+	{
+		std::ofstream out(temporary, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+		out << magic << '\n'
+			<< "path " << canonical << '\n'
+			<< "identity " << result.identity.device << ' ' << result.identity.inode << ' ' << result.identity.size
+			<< ' ' << result.identity.modified << '\n'
+			<< "hash " << std::hex << result.contentHash << std::dec << ' ' << result.hashedSize << '\n'
+			<< "valid " << result.valid << '\n'
+			<< "messages " << result.messages.size() << '\n'
+			<< result.messages;
+		if (!out.flush()) {
+			std::filesystem::remove(temporary, error);
+			return false;
+		}
+	}
+	std::filesystem::rename(temporary, path, error);
+	if (error) {
+		std::filesystem::remove(temporary, error);
+		return false;
+	}
+	return true;
+}
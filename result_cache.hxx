@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Identity of a file on disk, which changes whenever the file is rewritten or replaced
+struct FileIdentity {
+	uint64_t device = 0;
+	uint64_t inode = 0;
+	uint64_t size = 0;
+	// Modification time in nanoseconds
+	uint64_t modified = 0;
+
+	bool operator==(FileIdentity const &) const = default;
+};
+
+// False if fileName cannot be stat'ed
+bool fileIdentity(std::string const &fileName, FileIdentity &identity);
+
+struct CachedResult {
+	// The file as it was validated
+	FileIdentity identity;
+	// ContentHash of its first hashedSize bytes: all of them, unless validation stopped before the end. The result
+	// only depends on those, so a file of the same size that starts with them gets the same one.
+	uint64_t contentHash = 0;
+	uint64_t hashedSize = 0;
+	bool valid = false;
+	// What validating it printed to diagnostics()
+	std::string messages;
+};
+
+// Validation results on disk (--cache DIR), one entry per file and settings. settings names everything the
+// result depends on besides the file: the validator build, profile and error limit. The entry is found by the
+// file's path; whether it still applies is up to the caller, by its identity or content hash.
+class ResultCache {
+public:
+	ResultCache(std::string directory, std::string_view settings);
+
+	// The entry of fileName, false if there is none or it is unreadable
+	bool lookup(std::string const &fileName, CachedResult &result) const;
+	// Replaces the entry of fileName, creating the directory if needed; false if it cannot be written
+	bool store(std::string const &fileName, CachedResult const &result) const;
+
+private:
+	std::string entryPath(std::string const &fileName, std::string &canonical) const;
+
+	std::string directory;
+	uint64_t settingsHash;
+};
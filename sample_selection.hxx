@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Which sample columns data lines check (--samples, --sample-rate, --sites-only)
+struct SampleSelection {
+	// Only the samples of these names, all of them if empty
+	std::vector<std::string> names;
+	// Fraction of records whose samples are checked, picked by a hash of CHROM and POS so that every run picks the
+	// same ones however the input is split between threads. FORMAT must still be there on the others.
+	double rate = 1;
+	// Neither FORMAT nor the sample columns, which a sites-only file does not have
+	bool sitesOnly = false;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Fixed ring of slots passed from one producer thread to one consumer thread without locks: each side owns the
+// slots between the two counters that only it advances, and blocks on the other's counter (std::atomic::wait) when
+// the ring is full or empty. Slots are reused in place, so whatever buffers they hold are allocated once.
+template<typename Slot>
+class SpscRing {
+public:
+	explicit SpscRing(size_t capacity)
+		: slots(capacity)
+	{
+	}
+
+	// Producer: the next free slot, waiting for the consumer to release one; nullptr once the ring is closed
+	Slot *beginPush()
+	{
+		size_t const pushed = tail.load(std::memory_order_relaxed);
+		while (true) {
+			size_t const popped = head.load(std::memory_order_acquire);
+			if (closed.load(std::memory_order_acquire)) {
+				return nullptr;
+			}
+			if (pushed - popped < slots.size()) {
+				return &slots[pushed % slots.size()];
+			}
+			head.wait(popped, std::memory_order_acquire);
+		}
+	}
+	// Producer: hands the slot from beginPush() to the consumer
+	void commitPush()
+	{
+		tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		tail.notify_one();
+	}
+
+	// Consumer: the oldest filled slot, waiting for the producer to fill one
+	Slot &front()
+	{
+		size_t const popped = head.load(std::memory_order_relaxed);
+		size_t pushed = tail.load(std::memory_order_acquire);
+		while (pushed == popped) {
+			tail.wait(pushed, std::memory_order_acquire);
+			pushed = tail.load(std::memory_order_acquire);
+		}
+		return slots[popped % slots.size()];
+	}
+	// Consumer: gives the slot from front() back to the producer
+	void pop()
+	{
+		head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		head.notify_one();
+	}
+
+	// Consumer: stops the producer, whose beginPush() returns nullptr from now on. Releasing every slot moves head,
+	// which wakes a producer waiting for one.
+	void close()
+	{
+		closed.store(true, std::memory_order_release);
+		head.store(tail.load(std::memory_order_acquire), std::memory_order_release);
+		head.notify_one();
+	}
+
+private:
+	std::vector<Slot> slots;
+	// Slots popped and pushed so far, on cache lines of their own so the two threads do not contend over them
+	alignas(64) std::atomic<size_t> head = 0;
+	alignas(64) std::atomic<size_t> tail = 0;
+	alignas(64) std::atomic<bool> closed = false;
+};
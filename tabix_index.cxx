@@ -0,0 +1,222 @@
+#include "tabix_index.hxx"
+
+#include "bgzf_reader.hxx"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+// Reads the little-endian fields of an inflated index, throwing on truncation
+class IndexParser {
+public:
+	explicit IndexParser(std::string_view data)
+		: data(data)
+	{
+	}
+
+	template<typename T>
+	T read()
+	{
+		T value;
+		std::memcpy(&value, take(sizeof(T)).data(), sizeof(T));
+		return value; // Index files are little-endian, like every host this builds for
+	}
+
+	std::string_view take(size_t size)
+	{
+		if (size > data.size() - offset) {
+			throw std::runtime_error("Truncated index");
+		}
+		std::string_view const bytes = data.substr(offset, size);
+		offset += size;
+		return bytes;
+	}
+
+	size_t count()
+	{
+		auto const value = read<int32_t>();
+		if (value < 0) {
+			throw std::runtime_error("Malformed index");
+		}
+		return static_cast<size_t>(value);
+	}
+
+private:
+	std::string_view data;
+	size_t offset = 0;
+};
+
+// The tabix header shared by .tbi files and the auxiliary data of a VCF's .csi: column layout and sequence names
+std::vector<std::string> readSequenceNames(IndexParser &parser)
+{
+	for (int i = 0; i < 6; ++i) {
+		parser.read<int32_t>(); // format, col_seq, col_beg, col_end, meta, skip
+	}
+	std::string_view names = parser.take(parser.count());
+	std::vector<std::string> result;
+	while (!names.empty()) {
+		auto const end = names.find('\0');
+		result.emplace_back(names.substr(0, end));
+		names.remove_prefix(end == std::string_view::npos ? names.size() : end + 1);
+	}
+	return result;
+}
+
+// Bin numbers of the first bin of every level, the leaves last
+constexpr uint32_t firstBinOfLevel(int level)
+{
+	return ((1u << (3 * level)) - 1) / 7;
+}
+
+std::string inflateIndexFile(std::string const &path)
+{
+	std::ifstream file(path, std::ios_base::in | std::ios_base::binary);
+	if (!file.is_open()) {
+		throw std::runtime_error("Failed to open index");
+	}
+	BgzfReader reader(file, nullptr);
+	std::string data;
+	char buffer[1 << 16];
+	while (size_t const count = reader.read(buffer, sizeof(buffer))) {
+		data.append(buffer, count);
+	}
+	return data;
+}
+
+} // namespace
+
+TabixIndex TabixIndex::load(std::string const &path)
+{
+	std::string const data = inflateIndexFile(path);
+	IndexParser parser(data);
+	TabixIndex index;
+
+	std::string_view const magic = parser.take(4);
+	if (magic == std::string_view("TBI\1", 4)) {
+		size_t const referenceCount = parser.count();
+		index.names = readSequenceNames(parser);
+		index.references.resize(referenceCount);
+	} else if (magic == std::string_view("CSI\1", 4)) {
+		index.csi = true;
+		index.minShift = parser.read<int32_t>();
+		index.depth = parser.read<int32_t>();
+		if (index.minShift <= 0 || index.depth <= 0 || index.minShift + 3 * index.depth > 62) {
+			throw std::runtime_error("Malformed index");
+		}
+		size_t const auxSize = parser.count();
+		if (auxSize == 0) {
+			throw std::runtime_error("CSI index without sequence names");
+		}
+		IndexParser aux(parser.take(auxSize));
+		index.names = readSequenceNames(aux);
+		index.references.resize(parser.count());
+	} else {
+		throw std::runtime_error("Not a tabix or CSI index");
+	}
+	if (index.names.size() != index.references.size()) {
+		throw std::runtime_error("Malformed index");
+	}
+
+	for (auto &reference : index.references) {
+		size_t const binCount = parser.count();
+		for (size_t i = 0; i < binCount; ++i) {
+			auto const number = parser.read<uint32_t>();
+			Bin &bin = reference.bins[number];
+			if (index.csi) {
+				bin.leftOffset = parser.read<uint64_t>();
+			}
+			size_t const chunkCount = parser.count();
+			for (size_t j = 0; j < chunkCount; ++j) {
+				auto const begin = parser.read<uint64_t>();
+				auto const end = parser.read<uint64_t>();
+				bin.chunks.push_back({begin, end});
+			}
+		}
+		if (!index.csi) {
+			size_t const windowCount = parser.count();
+			reference.linear.resize(windowCount);
+			for (auto &offset : reference.linear) {
+				offset = parser.read<uint64_t>();
+			}
+		}
+		// The pseudo-bin holds statistics, not records
+		reference.bins.erase(firstBinOfLevel(index.depth + 1) + 1);
+	}
+	return index;
+}
+
+bool TabixIndex::hasContig(std::string_view contig) const
+{
+	return std::ranges::find(names, contig) != names.end();
+}
+
+uint64_t TabixIndex::minimumOffset(Reference const &reference, uint64_t begin) const
+{
+	if (!csi) {
+		if (reference.linear.empty()) {
+			return 0;
+		}
+		size_t const window = std::min<size_t>(begin >> minShift, reference.linear.size() - 1);
+		return reference.linear[window];
+	}
+	// The nearest bin containing begin that holds records, walking up from its leaf
+	uint32_t bin = firstBinOfLevel(depth) + static_cast<uint32_t>(begin >> minShift);
+	while (true) {
+		auto const found = reference.bins.find(bin);
+		if (found != reference.bins.end()) {
+			return found->second.leftOffset;
+		}
+		if (bin == 0) {
+			return 0;
+		}
+		bin = (bin - 1) >> 3;
+	}
+}
+
+std::vector<IndexChunk> TabixIndex::query(std::string_view contig, uint64_t begin, uint64_t end) const
+{
+	std::vector<IndexChunk> chunks;
+	auto const found = std::ranges::find(names, contig);
+	if (found == names.end()) {
+		return chunks;
+	}
+	Reference const &reference = references[static_cast<size_t>(found - names.begin())];
+
+	uint64_t const maxPosition = uint64_t {1} << (minShift + 3 * depth);
+	end = std::min(end, maxPosition);
+	if (begin >= end) {
+		return chunks;
+	}
+	uint64_t const minOffset = minimumOffset(reference, begin);
+
+	// Every bin overlapping the range, level by level like htslib's reg2bins
+	int shift = minShift + 3 * depth;
+	for (int level = 0; level <= depth; ++level, shift -= 3) {
+		uint32_t const first = firstBinOfLevel(level);
+		for (uint64_t bin = first + (begin >> shift); bin <= first + ((end - 1) >> shift); ++bin) {
+			auto const entry = reference.bins.find(static_cast<uint32_t>(bin));
+			if (entry == reference.bins.end()) {
+				continue;
+			}
+			for (auto const &chunk : entry->second.chunks) {
+				if (chunk.end > minOffset) {
+					chunks.push_back({std::max(chunk.begin, minOffset), chunk.end});
+				}
+			}
+		}
+	}
+
+	std::ranges::sort(chunks, {}, &IndexChunk::begin);
+	std::vector<IndexChunk> merged;
+	for (auto const &chunk : chunks) {
+		if (!merged.empty() && chunk.begin <= merged.back().end) {
+			merged.back().end = std::max(merged.back().end, chunk.end);
+		} else {
+			merged.push_back(chunk);
+		}
+	}
+	return merged;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// A run of a BGZF file between two virtual offsets (compressed block offset << 16 | offset inside the block)
+struct IndexChunk {
+	uint64_t begin;
+	uint64_t end;
+};
+
+// Binning index of a sorted, BGZF-compressed VCF: tabix (.tbi) or CSI (.csi)
+class TabixIndex {
+public:
+	// Reads and parses an index file. Throws std::runtime_error if it cannot be read or is malformed.
+	static TabixIndex load(std::string const &path);
+
+	// Sequence names in index (and so file) order
+	std::vector<std::string> const &contigs() const
+	{
+		return names;
+	}
+	bool hasContig(std::string_view contig) const;
+
+	// Chunks, sorted and merged, holding every record of contig that overlaps the 0-based half-open [begin, end);
+	// they can also hold records outside it
+	std::vector<IndexChunk> query(std::string_view contig, uint64_t begin, uint64_t end) const;
+
+private:
+	struct Bin {
+		// Smallest virtual offset of a record in this bin or its descendants (CSI only)
+		uint64_t leftOffset = 0;
+		std::vector<IndexChunk> chunks;
+	};
+	struct Reference {
+		std::unordered_map<uint32_t, Bin> bins;
+		// Tabix linear index: smallest virtual offset of a record overlapping each 16 kb window
+		std::vector<uint64_t> linear;
+	};
+
+	uint64_t minimumOffset(Reference const &reference, uint64_t begin) const;
+
+	int minShift = 14;
+	int depth = 5;
+	bool csi = false;
+	std::vector<std::string> names;
+	std::vector<Reference> references;
+};
@@ -0,0 +1,69 @@
+# Times genomic_validator on one input and fails if its records/s falls more than TOLERANCE percent below the
+# figure recorded for NAME in BASELINE, run by ctest as
+#
+#   cmake -DVALIDATOR=... -DINPUT=... -DNAME=... -DBASELINE=.../throughput_baseline.txt -DTOLERANCE=20
+#         [-DRUNS=3] ["-DARGUMENTS=--threads 4"] -P check_throughput.cmake
+#
+# The best of RUNS runs counts, as noise only ever slows a run down. BASELINE, in the build tree unless
+# GENOMIC_VALIDATOR_THROUGHPUT_BASELINE points elsewhere, has a line "NAME records/s" per check. A check without
+# one records its figure as the reference run of this host and passes; with GENOMIC_VALIDATOR_RECORD_BASELINE set in
+# the environment every check records its figure, replacing the old one.
+
+foreach(variable VALIDATOR INPUT NAME BASELINE TOLERANCE)
+	if(NOT DEFINED ${variable})
+		message(FATAL_ERROR "check_throughput.cmake needs -D${variable}=...")
+	endif()
+endforeach()
+if(NOT DEFINED RUNS)
+	set(RUNS 3)
+endif()
+separate_arguments(ARGUMENTS UNIX_COMMAND "${ARGUMENTS}")
+
+set(best 0)
+foreach(run RANGE 1 ${RUNS})
+	execute_process(
+		COMMAND "${VALIDATOR}" --no-cache --stats ${ARGUMENTS} "${INPUT}"
+		RESULT_VARIABLE result
+		OUTPUT_QUIET
+		ERROR_VARIABLE stats
+	)
+	if(NOT result EQUAL 0)
+		message(FATAL_ERROR "${INPUT} failed validation:\n${stats}")
+	endif()
+	if(NOT stats MATCHES "records: +[0-9]+ \\(([0-9.]+) records/s\\)")
+		message(FATAL_ERROR "No records/s in the --stats report:\n${stats}")
+	endif()
+	set(rate "${CMAKE_MATCH_1}")
+	# math() has integers only, and whole records/s are close enough
+	string(REGEX REPLACE "\\..*" "" rate "${rate}")
+	if(rate GREATER best)
+		set(best ${rate})
+	endif()
+endforeach()
+
+set(lines "")
+set(recorded "")
+if(EXISTS "${BASELINE}")
+	file(STRINGS "${BASELINE}" lines)
+endif()
+foreach(line IN LISTS lines)
+	if(line MATCHES "^${NAME} ([0-9]+)$")
+		set(recorded ${CMAKE_MATCH_1})
+	endif()
+endforeach()
+
+if(recorded STREQUAL "" OR DEFINED ENV{GENOMIC_VALIDATOR_RECORD_BASELINE})
+	list(FILTER lines EXCLUDE REGEX "^${NAME} ")
+	list(APPEND lines "${NAME} ${best}")
+	list(SORT lines)
+	list(JOIN lines "\n" text)
+	file(WRITE "${BASELINE}" "${text}\n")
+	message(STATUS "${NAME}: recorded ${best} records/s in ${BASELINE}")
+	return()
+endif()
+
+math(EXPR floor "${recorded} - ${recorded} * ${TOLERANCE} / 100")
+message(STATUS "${NAME}: ${best} records/s, baseline ${recorded}, at least ${floor} needed")
+if(best LESS floor)
+	message(FATAL_ERROR "${NAME}: ${best} records/s is more than ${TOLERANCE}% below the baseline of ${recorded}")
+endif()
@@ -0,0 +1,196 @@
+#include "reference_validator.hxx"
+
+#include "vcf_validation.hxx"
+
+#include <charconv>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <pthread.h>
+
+// Checks that the line validators accept and reject exactly the lines the reference implementation does, with the
+// same message: every header and data line of the given files, and mutations of each with a few characters
+// inserted, removed or replaced. Lines on which the reference throws are skipped, it has no verdict on them.
+// Exits with EXIT_FAILURE if any line is judged differently.
+
+namespace {
+
+struct Verdict {
+	bool valid = false;
+	std::string message;
+	bool threw = false;
+};
+
+Verdict referenceVerdict(std::string_view line)
+{
+	Verdict verdict;
+	std::ostringstream out;
+	std::streambuf *const previous = std::cerr.rdbuf(out.rdbuf());
+	try {
+		verdict.valid = line.starts_with("##") ? reference::validateHeaderLine(line) : reference::checkDataLines(line);
+	} catch (...) {
+		verdict.threw = true;
+	}
+	std::cerr.rdbuf(previous);
+	verdict.message = out.str();
+	return verdict;
+}
+
+Verdict validatorVerdict(std::string_view line)
+{
+	Verdict verdict;
+	std::ostringstream out;
+	{
+		DiagnosticsRedirect redirect(out);
+		verdict.valid = line.starts_with("##") ? validateHeaderLine(line) : validateBodyLine(line);
+	}
+	verdict.message = out.str();
+	return verdict;
+}
+
+// Characters the mutations are drawn from, the field and value delimiters and the characters of the fields
+constexpr std::string_view mutationAlphabet = "\t:,./|-0123456789ACGTNacgt*<>=;\"xXe+ ";
+
+void mutate(std::string &line, std::mt19937 &random)
+{
+	unsigned const count = 1 + random() % 3;
+	for (unsigned i = 0; i < count; ++i) {
+		size_t const position = random() % (line.size() + 1);
+		char const c = mutationAlphabet[random() % mutationAlphabet.size()];
+		switch (random() % 3) {
+		case 0:
+			line.insert(line.begin() + static_cast<ptrdiff_t>(position), c);
+			break;
+		case 1:
+			if (position < line.size()) {
+				line.erase(position, 1 + random() % 3);
+			}
+			break;
+		default:
+			if (position < line.size()) {
+				line[position] = c;
+			}
+		}
+	}
+}
+
+template<typename T>
+bool parseNumber(std::string_view text, T &value)
+{
+	auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+	return ec == std::errc() && ptr == text.data() + text.size();
+}
+
+constexpr size_t referenceStackSize = size_t {1} << 30;
+
+struct Comparison {
+	std::vector<std::string> const &fileNames;
+	unsigned seed;
+	unsigned mutations;
+	int result = EXIT_FAILURE;
+};
+
+// Compares every line of the files and its mutations, on a thread of pthread_create()
+void *compareFiles(void *argument)
+{
+	Comparison &comparison = *static_cast<Comparison *>(argument);
+	std::mt19937 random(comparison.seed);
+	uint64_t compared = 0;
+	uint64_t skipped = 0;
+	uint64_t mismatches = 0;
+	auto const compare = [&](std::string const &fileName, std::string_view line) {
+		Verdict const expected = referenceVerdict(line);
+		if (expected.threw) {
+			++skipped;
+			return;
+		}
+		Verdict const actual = validatorVerdict(line);
+		++compared;
+		if (actual.valid != expected.valid || actual.message != expected.message) {
+			// The first few are enough to go on, the count tells how widespread it is
+			if (mismatches++ < 10) {
+				std::cerr << fileName << ": mismatch on: " << line << "\n  reference: " << expected.valid << ' '
+						  << expected.message << "  validator: " << actual.valid << ' ' << actual.message << '\n';
+			}
+		}
+	};
+
+	for (std::string const &fileName : comparison.fileNames) {
+		std::ifstream file(fileName);
+		if (!file) {
+			std::cerr << "Failed to open file: " << fileName << '\n';
+			return nullptr;
+		}
+		std::string line;
+		std::string mutated;
+		while (std::getline(file, line)) {
+			// The column header line is checked against the header model, which the reference has no part of
+			if (line.starts_with("#CHROM")) {
+				continue;
+			}
+			compare(fileName, line);
+			for (unsigned i = 0; i < comparison.mutations; ++i) {
+				mutated = line;
+				mutate(mutated, random);
+				compare(fileName, mutated);
+			}
+		}
+	}
+
+	std::cout << compared << " lines compared, " << mismatches << " mismatches, " << skipped
+			  << " skipped where the reference threw\n";
+	comparison.result = mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+	return nullptr;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+	unsigned seed = 1;
+	unsigned mutations = 200;
+	std::vector<std::string> fileNames;
+	for (int i = 1; i < argc; ++i) {
+		std::string_view const arg = argv[i];
+		bool ok = true;
+		if (arg == "--seed" && i + 1 < argc) {
+			ok = parseNumber(argv[++i], seed);
+		} else if (arg == "--mutations" && i + 1 < argc) {
+			ok = parseNumber(argv[++i], mutations);
+		} else if (!arg.starts_with("--")) {
+			fileNames.emplace_back(arg);
+		} else {
+			ok = false;
+		}
+		if (!ok) {
+			fileNames.clear();
+			break;
+		}
+	}
+	if (fileNames.empty()) {
+		std::cerr << "Usage: " << argv[0] << " [--seed N] [--mutations N] <VCF filename>...\n"
+				  << "  --seed N       random seed of the mutations (default 1)\n"
+				  << "  --mutations N  mutated copies of each line to compare (default 200)\n";
+		return EXIT_FAILURE;
+	}
+
+	Comparison comparison {fileNames, seed, mutations};
+	// std::regex matches recursively, so the reference needs far more stack for a long REF than a thread starts with
+	pthread_attr_t attributes;
+	pthread_attr_init(&attributes);
+	pthread_attr_setstacksize(&attributes, referenceStackSize);
+	pthread_t thread;
+	if (pthread_create(&thread, &attributes, compareFiles, &comparison) != 0) {
+		std::cerr << "Failed to start the comparison thread\n";
+		return EXIT_FAILURE;
+	}
+	pthread_join(thread, nullptr);
+	pthread_attr_destroy(&attributes);
+	return comparison.result;
+}
@@ -0,0 +1,95 @@
+# Validates one corpus file with --checkpoint and continues with --resume, run by ctest as
+#
+#   cmake -DVALIDATOR=... -DGENERATOR=... -DINPUT=file.vcf -DCOMPRESSION=none|bgzf -DTRAILING_NEWLINE=ON|OFF
+#         -DWORK_DIR=... ["-DARGUMENTS=--profile non-human"] -P run_checkpoint_case.cmake
+#
+# The first run checkpoints a copy holding the header and the first record only. The copy is then replaced by the
+# whole file, optionally without the newline after its last line, and validated twice with --resume: once
+# continuing after that first record and once from the checkpoint at its end. Every run must print what a run
+# without a checkpoint prints for the same text, and the resumed ones must skip what was validated before.
+
+foreach(variable VALIDATOR GENERATOR INPUT COMPRESSION TRAILING_NEWLINE WORK_DIR)
+	if(NOT DEFINED ${variable})
+		message(FATAL_ERROR "run_checkpoint_case.cmake needs -D${variable}=...")
+	endif()
+endforeach()
+separate_arguments(ARGUMENTS UNIX_COMMAND "${ARGUMENTS}")
+
+file(MAKE_DIRECTORY "${WORK_DIR}")
+get_filename_component(name "${INPUT}" NAME)
+set(text "${WORK_DIR}/${name}")
+set(file "${text}")
+if(COMPRESSION STREQUAL "bgzf")
+	set(file "${text}.gz")
+endif()
+file(REMOVE "${file}.vcfcheck")
+
+# Writes content to the file validated, compressed when asked for
+function(write_input content)
+	file(WRITE "${text}" "${content}")
+	if(COMPRESSION STREQUAL "bgzf")
+		execute_process(
+			COMMAND "${GENERATOR}" --from "${text}" --compression bgzf "${file}"
+			RESULT_VARIABLE result
+		)
+		if(NOT result EQUAL 0)
+			message(FATAL_ERROR "Failed to compress ${text}")
+		endif()
+	endif()
+endfunction()
+
+# Runs the validator on the file and sets <prefix>_output to its exit code and output, <prefix>_records to the
+# records it validated
+function(validate prefix)
+	execute_process(
+		COMMAND "${VALIDATOR}" --no-cache --stats ${ARGUMENTS} ${ARGN} "${file}"
+		RESULT_VARIABLE result
+		OUTPUT_VARIABLE output
+		ERROR_VARIABLE errors
+	)
+	if(NOT errors MATCHES "records: +([0-9]+) ")
+		message(FATAL_ERROR "No records in the --stats report:\n${errors}")
+	endif()
+	set(${prefix}_records ${CMAKE_MATCH_1} PARENT_SCOPE)
+	set(${prefix}_output "exit code ${result}\n${output}" PARENT_SCOPE)
+endfunction()
+
+function(expect_output prefix expected)
+	if(NOT ${prefix}_output STREQUAL expected)
+		message(FATAL_ERROR
+			"${prefix} run of ${file} differs\n--- expected\n${expected}--- actual\n${${prefix}_output}")
+	endif()
+endfunction()
+
+file(READ "${INPUT}" contents)
+string(REGEX MATCH "^(.*\n)?#CHROM[^\n]*\n[^\n]*\n" first "${contents}")
+if(first STREQUAL "")
+	message(FATAL_ERROR "${INPUT} has no record after its column header line")
+endif()
+string(REGEX REPLACE "\n$" "" whole "${contents}")
+if(TRAILING_NEWLINE)
+	string(APPEND whole "\n")
+endif()
+
+write_input("${first}")
+validate(plain_first)
+validate(first --checkpoint 1)
+expect_output(first "${plain_first_output}")
+if(NOT EXISTS "${file}.vcfcheck")
+	message(FATAL_ERROR "--checkpoint wrote no ${file}.vcfcheck")
+endif()
+
+write_input("${whole}")
+validate(plain)
+validate(appended --resume)
+expect_output(appended "${plain_output}")
+math(EXPR remaining "${plain_records} - ${first_records}")
+if(NOT appended_records EQUAL remaining)
+	message(FATAL_ERROR
+		"--resume validated ${appended_records} records of ${file}, expected the ${remaining} after the first")
+endif()
+validate(again --resume)
+expect_output(again "${plain_output}")
+if(NOT again_records EQUAL 0)
+	message(FATAL_ERROR "--resume validated ${again_records} records of ${file} again")
+endif()
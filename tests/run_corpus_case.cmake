@@ -0,0 +1,53 @@
+# Validates one corpus file and compares the exit code and output with its golden file, run by ctest as
+#
+#   cmake -DVALIDATOR=... -DGENERATOR=... -DINPUT=file.vcf -DEXPECTED=file.expected -DCOMPRESSION=none|gzip|bgzf
+#         [-DTHREADS=N] -DWORK_DIR=... -P run_corpus_case.cmake
+#
+# With COMPRESSION gzip or bgzf the file is compressed by vcf_generator --from first, so every case checks the
+# decompressors as well and the golden file stays the same. With GENOMIC_VALIDATOR_UPDATE_GOLDEN set in the
+# environment the golden file is written from the plain serial case rather than compared with.
+
+foreach(variable VALIDATOR GENERATOR INPUT EXPECTED COMPRESSION WORK_DIR)
+	if(NOT DEFINED ${variable})
+		message(FATAL_ERROR "run_corpus_case.cmake needs -D${variable}=...")
+	endif()
+endforeach()
+
+set(file "${INPUT}")
+if(NOT COMPRESSION STREQUAL "none")
+	get_filename_component(name "${INPUT}" NAME)
+	file(MAKE_DIRECTORY "${WORK_DIR}")
+	set(file "${WORK_DIR}/${name}.${COMPRESSION}.gz")
+	execute_process(
+		COMMAND "${GENERATOR}" --from "${INPUT}" --compression "${COMPRESSION}" "${file}"
+		RESULT_VARIABLE result
+	)
+	if(NOT result EQUAL 0)
+		message(FATAL_ERROR "Failed to compress ${INPUT}")
+	endif()
+endif()
+
+set(arguments --no-cache --max-errors 0)
+if(DEFINED THREADS)
+	list(APPEND arguments --threads ${THREADS})
+endif()
+execute_process(
+	COMMAND "${VALIDATOR}" ${arguments} "${file}"
+	RESULT_VARIABLE result
+	OUTPUT_VARIABLE output
+	ERROR_VARIABLE errors
+)
+set(actual "exit code ${result}\n${output}${errors}")
+
+if(DEFINED ENV{GENOMIC_VALIDATOR_UPDATE_GOLDEN})
+	if(COMPRESSION STREQUAL "none" AND NOT DEFINED THREADS)
+		file(WRITE "${EXPECTED}" "${actual}")
+		message(STATUS "Wrote ${EXPECTED}")
+	endif()
+	return()
+endif()
+
+file(READ "${EXPECTED}" expected)
+if(NOT actual STREQUAL expected)
+	message(FATAL_ERROR "Output of ${file} differs from ${EXPECTED}\n--- expected\n${expected}--- actual\n${actual}")
+endif()
@@ -0,0 +1,117 @@
+#include "validation_server.hxx"
+
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Sends two DATA requests over one connection to a server with a single connection thread, so that both are
+// validated by the same VcfValidator: the headers type the same FORMAT key differently and each answer must be the
+// one the file gets on its own. Usage: validation_server_reuse <socket path>
+
+namespace {
+
+constexpr std::string_view stringKey = "##fileformat=VCFv4.2\n"
+									   "##FORMAT=<ID=XX,Number=1,Type=String,Description=\"Text\">\n"
+									   "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tS1\n"
+									   "chr1\t100\t.\tA\tG\t50\tPASS\t.\tXX\tabc\n";
+
+constexpr std::string_view integerKey = "##fileformat=VCFv4.2\n"
+										"##FORMAT=<ID=XX,Number=1,Type=Integer,Description=\"Number\">\n"
+										"#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tS1\n"
+										"chr1\t100\t.\tA\tG\t50\tPASS\t.\tXX\tabc\n";
+
+// A connection to the server at path, retried while it starts up; -1 if it does not come up
+int connectTo(std::string const &path)
+{
+	sockaddr_un address {};
+	address.sun_family = AF_UNIX;
+	path.copy(address.sun_path, sizeof(address.sun_path) - 1);
+	for (int attempt = 0; attempt < 500; ++attempt) {
+		int const fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if (fd < 0) {
+			return -1;
+		}
+		if (::connect(fd, reinterpret_cast<sockaddr const *>(&address), sizeof(address)) == 0) {
+			return fd;
+		}
+		::close(fd);
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	return -1;
+}
+
+// Sends a DATA request and returns the answer line, empty if the connection fails
+std::string request(int fd, std::string_view data)
+{
+	std::string const text = "DATA " + std::to_string(data.size()) + "\n" + std::string(data);
+	for (std::string_view rest = text; !rest.empty();) {
+		ssize_t const sent = ::send(fd, rest.data(), rest.size(), MSG_NOSIGNAL);
+		if (sent <= 0) {
+			return {};
+		}
+		rest.remove_prefix(static_cast<size_t>(sent));
+	}
+	std::string answer;
+	char c = 0;
+	while (::recv(fd, &c, 1, 0) == 1 && c != '\n') {
+		answer.push_back(c);
+	}
+	return answer;
+}
+
+bool check(std::string_view what, std::string const &answer, bool valid)
+{
+	bool const passed = answer.starts_with(valid ? "{\"valid\":true," : "{\"valid\":false,")
+		&& (valid || answer.find("Invalid data for XX: abc") != std::string::npos);
+	if (!passed) {
+		std::cerr << what << ": unexpected answer: " << answer << '\n';
+	}
+	return passed;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+	if (argc != 2) {
+		std::cerr << "Usage: " << argv[0] << " <socket path>\n";
+		return EXIT_FAILURE;
+	}
+	std::string const socketPath = argv[1];
+
+	// Blocked here too, so that the signal stopping the server is only ever taken by its sigwait()
+	sigset_t signals;
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGINT);
+	sigaddset(&signals, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+	bool served = false;
+	std::thread server([&] {
+		served = serveValidation(socketPath, {}, [](std::string const &, ThreadPool *) { return false; });
+	});
+
+	bool passed = false;
+	int const fd = connectTo(socketPath);
+	if (fd < 0) {
+		std::cerr << "Failed to connect to " << socketPath << '\n';
+	} else {
+		passed = check("String XX", request(fd, stringKey), true);
+		passed &= check("Integer XX after String XX", request(fd, integerKey), false);
+		passed &= check("String XX after Integer XX", request(fd, stringKey), true);
+		::close(fd);
+	}
+
+	pthread_kill(server.native_handle(), SIGTERM);
+	server.join();
+	return passed && served ? EXIT_SUCCESS : EXIT_FAILURE;
+}
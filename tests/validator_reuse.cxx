@@ -0,0 +1,47 @@
+#include "vcf_validator.hxx"
+
+#include <cstdlib>
+#include <iostream>
+#include <string_view>
+
+// One VcfValidator validating file after file must judge each as a fresh one would: here two files type the same
+// FORMAT key differently, so a FORMAT dispatch resolved against the first header must not be used for the second.
+
+namespace {
+
+constexpr std::string_view stringKey = "##fileformat=VCFv4.2\n"
+									   "##FORMAT=<ID=XX,Number=1,Type=String,Description=\"Text\">\n"
+									   "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tS1\n"
+									   "chr1\t100\t.\tA\tG\t50\tPASS\t.\tXX\tabc\n";
+
+constexpr std::string_view integerKey = "##fileformat=VCFv4.2\n"
+										"##FORMAT=<ID=XX,Number=1,Type=Integer,Description=\"Number\">\n"
+										"#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tS1\n"
+										"chr1\t100\t.\tA\tG\t50\tPASS\t.\tXX\tabc\n";
+
+bool check(std::string_view what, bool actual, bool expected)
+{
+	if (actual != expected) {
+		std::cerr << what << ": " << (actual ? "valid" : "invalid") << ", expected "
+				  << (expected ? "valid" : "invalid") << '\n';
+	}
+	return actual == expected;
+}
+
+} // namespace
+
+int main()
+{
+	bool passed = true;
+	{
+		VcfValidator validator;
+		passed &= check("String XX", validator.validate(stringKey), true);
+		passed &= check("Integer XX after String XX", validator.validate(integerKey), false);
+		passed &= check("String XX after Integer XX", validator.validate(stringKey), true);
+	}
+	{
+		VcfValidator validator;
+		passed &= check("Integer XX, new validator in its place", validator.validate(integerKey), false);
+	}
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
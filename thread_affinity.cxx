@@ -0,0 +1,206 @@
+#include "thread_affinity.hxx"
+
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+
+#include <pthread.h>
+#include <sched.h>
+
+namespace {
+
+AffinityPlan activePlan;
+// The CPUs the process could run on before setAffinity() moved the calling thread, for the stages the plan leaves
+// to the scheduler: a new thread inherits its creator's CPUs, which would otherwise be those of Main
+cpu_set_t originalCpus;
+bool placing = false;
+
+// Parses a CPU list of the kind sysfs and taskset use, 0-3,8,10-11, into cpus
+bool parseCpuList(std::string_view text, std::vector<unsigned> &cpus)
+{
+	cpus.clear();
+	while (!text.empty()) {
+		size_t const comma = std::min(text.find(','), text.size());
+		std::string_view const range = text.substr(0, comma);
+		text.remove_prefix(std::min(comma + 1, text.size()));
+
+		size_t const dash = std::min(range.find('-'), range.size());
+		unsigned first = 0;
+		unsigned last = 0;
+		auto const parse = [](std::string_view number, unsigned &value) {
+			auto [ptr, ec] = std::from_chars(number.data(), number.data() + number.size(), value);
+			return !number.empty() && ec == std::errc() && ptr == number.data() + number.size();
+		};
+		if (!parse(range.substr(0, dash), first)) {
+			return false;
+		}
+		last = first;
+		if (dash != range.size() && (!parse(range.substr(dash + 1), last) || last < first)) {
+			return false;
+		}
+		for (unsigned cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu) {
+			cpus.push_back(cpu);
+		}
+	}
+	std::sort(cpus.begin(), cpus.end());
+	cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+	return true;
+}
+
+// The CPUs the process may run on, by NUMA node as sysfs lists them; one node of them all without NUMA information
+std::vector<std::vector<unsigned>> allowedCpusByNode()
+{
+	cpu_set_t allowed;
+	CPU_ZERO(&allowed);
+	if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+		return {};
+	}
+	std::vector<unsigned> all;
+	for (unsigned cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+		if (CPU_ISSET(cpu, &allowed)) {
+			all.push_back(cpu);
+		}
+	}
+
+	std::vector<std::vector<unsigned>> nodes;
+	for (unsigned node = 0;; ++node) {
+		std::string const directory = "/sys/devices/system/node/node" + std::to_string(node);
+		std::error_code error;
+		if (!std::filesystem::exists(directory, error)) {
+			break;
+		}
+		std::ifstream file(directory + "/cpulist");
+		std::string text;
+		std::vector<unsigned> cpus;
+		if (!std::getline(file, text) || !parseCpuList(text, cpus)) {
+			return {all};
+		}
+		std::erase_if(cpus, [&allowed](unsigned cpu) { return !CPU_ISSET(cpu, &allowed); });
+		nodes.push_back(std::move(cpus));
+	}
+	if (nodes.empty()) {
+		nodes.push_back(std::move(all));
+	}
+	return nodes;
+}
+
+bool parsePlacement(std::string_view text, bool workers, std::vector<unsigned> &cpus)
+{
+	auto const nodes = allowedCpusByNode();
+	cpus.clear();
+	if (text == "compact" || text == "spread") {
+		if (!workers) {
+			return false;
+		}
+		if (text == "compact") {
+			for (auto const &node : nodes) {
+				cpus.insert(cpus.end(), node.begin(), node.end());
+			}
+		} else {
+			size_t widest = 0;
+			for (auto const &node : nodes) {
+				widest = std::max(widest, node.size());
+			}
+			for (size_t i = 0; i < widest; ++i) {
+				for (auto const &node : nodes) {
+					if (i < node.size()) {
+						cpus.push_back(node[i]);
+					}
+				}
+			}
+		}
+	} else if (text.starts_with("node")) {
+		unsigned node = 0;
+		std::string_view const number = text.substr(4);
+		auto [ptr, ec] = std::from_chars(number.data(), number.data() + number.size(), node);
+		if (number.empty() || ec != std::errc() || ptr != number.data() + number.size() || node >= nodes.size()) {
+			return false;
+		}
+		cpus = nodes[node];
+	} else {
+		std::vector<unsigned> listed;
+		if (!parseCpuList(text, listed)) {
+			return false;
+		}
+		for (auto const &node : nodes) {
+			std::ranges::copy_if(node, std::back_inserter(cpus), [&listed](unsigned cpu) {
+				return std::binary_search(listed.begin(), listed.end(), cpu);
+			});
+		}
+		std::sort(cpus.begin(), cpus.end());
+	}
+	return !cpus.empty();
+}
+
+} // namespace
+
+bool parseAffinity(std::string_view text, AffinityPlan &plan)
+{
+	constexpr std::pair<std::string_view, ThreadStage> stages[] = {
+		{"main", ThreadStage::Main},
+		{"reader", ThreadStage::Reader},
+		{"inflate", ThreadStage::Inflate},
+		{"workers", ThreadStage::Workers},
+	};
+	plan = {};
+	if (text.empty()) {
+		return false;
+	}
+	while (!text.empty()) {
+		size_t const colon = std::min(text.find(':'), text.size());
+		std::string_view item = text.substr(0, colon);
+		text.remove_prefix(std::min(colon + 1, text.size()));
+
+		ThreadStage stage = ThreadStage::Workers;
+		if (size_t const equals = item.find('='); equals != std::string_view::npos) {
+			std::string_view const name = item.substr(0, equals);
+			auto const *const named
+				= std::find_if(std::begin(stages), std::end(stages), [name](auto const &s) { return s.first == name; });
+			if (named == std::end(stages)) {
+				return false;
+			}
+			stage = named->second;
+			item.remove_prefix(equals + 1);
+		}
+		if (!parsePlacement(item, stage == ThreadStage::Workers, plan.cpus[static_cast<size_t>(stage)])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void setAffinity(AffinityPlan plan)
+{
+	activePlan = std::move(plan);
+	CPU_ZERO(&originalCpus);
+	placing = std::ranges::any_of(activePlan.cpus, [](auto const &cpus) { return !cpus.empty(); })
+		&& pthread_getaffinity_np(pthread_self(), sizeof(originalCpus), &originalCpus) == 0;
+	placeThread(ThreadStage::Main);
+}
+
+void placeThread(ThreadStage stage, size_t index)
+{
+	if (!placing) {
+		return;
+	}
+	std::vector<unsigned> const &cpus = activePlan.cpus[static_cast<size_t>(stage)];
+	if (cpus.empty()) {
+		pthread_setaffinity_np(pthread_self(), sizeof(originalCpus), &originalCpus);
+		return;
+	}
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	if (stage == ThreadStage::Workers) {
+		CPU_SET(cpus[index % cpus.size()], &set);
+	} else {
+		for (unsigned const cpu : cpus) {
+			CPU_SET(cpu, &set);
+		}
+	}
+	// Placement only helps, a thread that cannot be moved runs where it is
+	pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+// The threads of the validator that --affinity places
+enum class ThreadStage
+{
+	Main, // Validates the file: the header, serial validation, the collector of the pipeline; --serve connections
+	Reader, // Cuts the input into blocks for the workers; the read-ahead's pread threads
+	Inflate, // Inflates plain gzip ahead of validation (pipelined_input.hxx)
+	Workers, // Pool workers validating blocks and inflating BGZF batches
+};
+constexpr size_t threadStageCount = 4;
+
+// CPUs of each stage, empty where the stage is left to the scheduler on the CPUs the process started with. Pool
+// workers are pinned to one CPU of theirs each in turn, the other stages run on any CPU of theirs.
+struct AffinityPlan {
+	std::array<std::vector<unsigned>, threadStageCount> cpus;
+};
+
+// Parses --affinity: one or more ITEMs separated by ':', ITEM = [STAGE=]PLACEMENT with STAGE main, reader, inflate
+// or workers (the default) and PLACEMENT
+//   compact  the CPUs node by node, so workers fill one NUMA node before the next (workers only)
+//   spread   the CPUs of the nodes in turn, so workers are spread evenly over the nodes (workers only)
+//   nodeN    the CPUs of NUMA node N
+//   LIST     the CPUs of a list such as 0-7,16-23
+// Only CPUs the process may run on count. False if text is malformed or leaves a stage without CPUs.
+bool parseAffinity(std::string_view text, AffinityPlan &plan);
+
+// Places the threads of each stage as plan says from now on, the calling thread as Main. Call it before validation
+// starts any threads.
+void setAffinity(AffinityPlan plan);
+
+// Moves the calling thread to the CPUs of its stage, the index-th CPU of them in turn for a worker, or back to the
+// CPUs the process had before setAffinity() for a stage without CPUs. Threads call it when they start, before they
+// allocate anything, so that the buffers each keeps for itself are first touched, and so placed, on its own NUMA
+// node.
+void placeThread(ThreadStage stage, size_t index = 0);
@@ -0,0 +1,115 @@
+#include "thread_pool.hxx"
+
+#include "thread_affinity.hxx"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace {
+
+// The pool and queue of the worker running on this thread, so that its own submissions stay on its queue
+thread_local void const *workerPool = nullptr;
+thread_local size_t workerQueue = 0;
+
+std::atomic<size_t> nextQueue = 0;
+
+} // namespace
+
+void ThreadPool::TaskQueue::push(std::function<void()> task)
+{
+	std::lock_guard lock(mutex);
+	tasks.push_back(std::move(task));
+}
+
+bool ThreadPool::TaskQueue::pop(std::function<void()> &task)
+{
+	std::lock_guard lock(mutex);
+	if (first == tasks.size()) {
+		return false;
+	}
+	task = std::move(tasks[first++]);
+	// Drop the tasks already taken once they are the larger part
+	if (first * 2 >= tasks.size()) {
+		tasks.erase(tasks.begin(), tasks.begin() + static_cast<std::ptrdiff_t>(first));
+		first = 0;
+	}
+	return true;
+}
+
+ThreadPool::ThreadPool(unsigned threadCount)
+{
+	queues.resize(std::max(threadCount, 1u));
+	for (auto &queue : queues) {
+		queue = std::make_unique<TaskQueue>();
+	}
+	workers.reserve(threadCount);
+	for (unsigned i = 0; i < threadCount; ++i) {
+		workers.emplace_back([this, i] { workerLoop(i); });
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard lock(mutex);
+		stopping = true;
+	}
+	wakeUp.notify_all();
+	for (auto &worker : workers) {
+		worker.join();
+	}
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+	size_t const queue = workerPool == this ? workerQueue
+											: nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+	// Counted before it is queued, so a worker that finds pending tasks but no queued ones only retries
+	{
+		std::lock_guard lock(mutex);
+		++pending;
+	}
+	queues[queue]->push(std::move(task));
+	wakeUp.notify_one();
+}
+
+unsigned ThreadPool::size() const
+{
+	return static_cast<unsigned>(workers.size());
+}
+
+bool ThreadPool::take(size_t index, std::function<void()> &task)
+{
+	for (size_t i = 0; i < queues.size(); ++i) {
+		if (queues[(index + i) % queues.size()]->pop(task)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void ThreadPool::workerLoop(size_t index)
+{
+	placeThread(ThreadStage::Workers, index);
+	workerPool = this;
+	workerQueue = index;
+	while (true) {
+		std::function<void()> task;
+		if (take(index, task)) {
+			{
+				std::lock_guard lock(mutex);
+				--pending;
+			}
+			task();
+			continue;
+		}
+
+		std::unique_lock lock(mutex);
+		wakeUp.wait(lock, [this] { return stopping || pending != 0; });
+		if (pending == 0) {
+			return; // Stopping and drained
+		}
+	}
+}
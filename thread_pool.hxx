@@ -0,0 +1,50 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool of worker threads with a task queue per worker. Tasks submitted from outside the pool are dealt
+// to the queues in turn, a task submitted by a worker goes to its own queue; a worker whose queue is empty steals
+// the oldest task of another, so one long task does not hold up the tasks queued behind it. Every queue runs in
+// FIFO order. Workers are placed on CPUs as --affinity says (thread_affinity.hxx).
+class ThreadPool {
+public:
+	explicit ThreadPool(unsigned threadCount);
+	// Runs every task that was already submitted, then joins the workers
+	~ThreadPool();
+
+	ThreadPool(ThreadPool const &) = delete;
+	ThreadPool &operator=(ThreadPool const &) = delete;
+
+	void submit(std::function<void()> task);
+	unsigned size() const;
+
+private:
+	// Pending tasks start at first; a vector rather than a deque so that a steady stream of tasks reuses its
+	// capacity instead of allocating a chunk every few submissions
+	struct TaskQueue {
+		std::mutex mutex;
+		std::vector<std::function<void()>> tasks;
+		size_t first = 0;
+
+		void push(std::function<void()> task);
+		bool pop(std::function<void()> &task);
+	};
+
+	void workerLoop(size_t index);
+	// Takes a task from the worker's own queue, or else from the others
+	bool take(size_t index, std::function<void()> &task);
+
+	std::vector<std::unique_ptr<TaskQueue>> queues;
+	// Guards pending and stopping, which the idle workers wait on
+	std::mutex mutex;
+	std::condition_variable wakeUp;
+	size_t pending = 0;
+	bool stopping = false;
+	std::vector<std::thread> workers;
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "sample_selection.hxx"
+#include "validation_profile.hxx"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+struct ValidationOptions {
+	// Worker threads validating data lines, 1 validates on the reading thread
+	unsigned threads = 1;
+	// Decompressed bytes handed to a worker at a time
+	size_t blockSize = size_t{4} << 20;
+	// Invalid lines reported before validation stops, 1 is fail-fast and 0 reports them all, as --max-errors 0 does
+	size_t maxErrors = 1;
+	// Validate only these regions (--region, --regions-file) through the index, see region_validator.hxx
+	std::vector<std::string> regions;
+	std::string regionsFile;
+	// Validate every contig of the index as its own task
+	bool parallelContigs = false;
+	// Compressed input is read in readBlockSize pieces with readAheadDepth reads in flight (read_ahead.hxx), through
+	// io_uring unless readAheadThreads; depth 0 reads it with std::ifstream instead
+	size_t readAheadDepth = 4;
+	size_t readBlockSize = size_t {1} << 20;
+	bool readAheadThreads = false;
+	// Plain gzip, and BGZF without worker threads, is inflated on a thread of its own up to inflateAheadDepth 1 MiB
+	// buffers ahead of validation (pipelined_input.hxx); 0 inflates on the validating thread
+	size_t inflateAheadDepth = 4;
+	// Write a checkpoint (checkpoint.hxx) every checkpointBlocks BGZF blocks, or 64 KiB of uncompressed input, and
+	// continue from the one a previous run left; 0 disables. Validation with checkpoints is serial.
+	size_t checkpointBlocks = 0;
+	static constexpr size_t defaultCheckpointBlocks = 1024;
+	// Reuse results stored in this directory (result_cache.hxx) for files unchanged since, and store new ones; empty
+	// disables. With cacheVerify an entry applies when the content hash matches rather than the file's identity.
+	std::string cacheDirectory;
+	bool cacheVerify = false;
+	// Checks data lines get (--profile)
+	ValidationProfile profile = ValidationProfile::Strict;
+	// Sample columns they check (--samples, --sample-rate, --sites-only)
+	SampleSelection samples;
+	// Write the header and the data lines that pass to filterOutput, "-" for stdout, and with rejectsOutput the header
+	// and the data lines that fail to that (filtered_output.hxx); validation then goes on past maxErrors to the end
+	std::string filterOutput;
+	std::string rejectsOutput;
+	// Print per-stage timings and counters at exit (--stats), optionally also as JSON to statsJsonFile
+	bool stats = false;
+	std::string statsJsonFile;
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+// Which checks data lines get (--profile). Every profile compiles into its own data line validator with the checks
+// it leaves out removed, see checkDataLines in vcf_validation.cxx.
+enum class ValidationProfile
+{
+	Strict, // Everything, the default
+	Structural, // Columns, CHROM and POS, contigs, sorted order and alleles; no QUAL, FILTER, INFO or sample checks
+	HumanGrch38, // Strict, and POS within the GRCh38 length of chromosomes the header declares no length for
+	NonHuman, // Strict without requiring human chromosome names
+};
+
+// Feature set of a profile, the non-type template parameter of the specialized validators
+struct DataLineChecks {
+	// CHROM must name a human chromosome (isHumanChromosome)
+	bool humanChromosomes = true;
+	// POS must not exceed the GRCh38 length of a primary assembly chromosome whose length the header does not give
+	bool grch38Lengths = false;
+	// ID, QUAL, FILTER and INFO, with INFO entries checked against their ##INFO declarations
+	bool valueColumns = true;
+	// FORMAT and the sample columns
+	bool samples = true;
+};
+
+constexpr DataLineChecks profileChecks(ValidationProfile profile)
+{
+	switch (profile) {
+	case ValidationProfile::Structural:
+		return {.humanChromosomes = false, .valueColumns = false, .samples = false};
+	case ValidationProfile::HumanGrch38:
+		return {.grch38Lengths = true};
+	case ValidationProfile::NonHuman:
+		return {.humanChromosomes = false};
+	case ValidationProfile::Strict:
+		break;
+	}
+	return {};
+}
+
+namespace profile_detail {
+constexpr std::array<std::string_view, 4> names = {"strict", "structural", "human-GRCh38", "non-human"};
+}
+
+constexpr std::string_view profileName(ValidationProfile profile)
+{
+	return profile_detail::names[static_cast<size_t>(profile)];
+}
+
+// Profile called name on the command line, false if there is none
+constexpr bool parseProfile(std::string_view name, ValidationProfile &profile)
+{
+	for (size_t i = 0; i < profile_detail::names.size(); ++i) {
+		if (profile_detail::names[i] == name) {
+			profile = static_cast<ValidationProfile>(i);
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,377 @@
+#include "validation_server.hxx"
+
+#include "error_sink.hxx"
+#include "thread_affinity.hxx"
+#include "thread_pool.hxx"
+#include "vcf_validation.hxx"
+#include "vcf_validator.hxx"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <mutex>
+#include <span>
+#include <sstream>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <csignal>
+#include <fmt/format.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// Longest request line, enough for any path
+constexpr size_t maxRequestLine = 8192;
+constexpr size_t readBufferSize = size_t {64} << 10;
+
+void appendJsonString(std::string &out, std::string_view text)
+{
+	out.push_back('"');
+	for (char const c : text) {
+		switch (c) {
+		case '"':
+			out += "\\\"";
+			break;
+		case '\\':
+			out += "\\\\";
+			break;
+		case '\n':
+			out += "\\n";
+			break;
+		case '\t':
+			out += "\\t";
+			break;
+		default:
+			if (static_cast<unsigned char>(c) < 0x20) {
+				fmt::format_to(std::back_inserter(out), "\\u{:04x}", static_cast<unsigned>(c));
+			} else {
+				out.push_back(c);
+			}
+		}
+	}
+	out.push_back('"');
+}
+
+// The answer to a request: messages are the lines printed while validating it, errors are given as objects
+void appendResult(std::string &out, bool valid, double seconds, std::string_view messages,
+	std::span<ValidationError const> errors, bool withErrors)
+{
+	fmt::format_to(std::back_inserter(out), "{{\"valid\":{},\"seconds\":{:.6f},\"messages\":[", valid, seconds);
+	for (bool first = true; !messages.empty(); first = false) {
+		size_t const newline = std::min(messages.find('\n'), messages.size());
+		if (!first) {
+			out.push_back(',');
+		}
+		appendJsonString(out, messages.substr(0, newline));
+		messages.remove_prefix(std::min(newline + 1, messages.size()));
+	}
+	out.push_back(']');
+	if (withErrors) {
+		out += ",\"errors\":[";
+		std::string message;
+		for (size_t i = 0; i < errors.size(); ++i) {
+			message.clear();
+			formatErrors(errors.subspan(i, 1), false, message);
+			message.pop_back(); // The newline
+			fmt::format_to(std::back_inserter(out), "{}{{\"line\":{},\"column\":{},\"message\":", i == 0 ? "" : ",",
+				errors[i].line, errors[i].column);
+			appendJsonString(out, message);
+			out.push_back('}');
+		}
+		out.push_back(']');
+	}
+	out += "}\n";
+}
+
+// Requests read from a client through a buffer, and the answers sent back
+class Connection {
+public:
+	explicit Connection(int fd)
+		: fd(fd)
+		, buffer(readBufferSize)
+	{
+	}
+
+	// The next request line without its newline, false at the end of the connection or if the line is too long
+	bool readLine(std::string &line)
+	{
+		while (true) {
+			char const *const first = buffer.data() + begin;
+			char const *const last = buffer.data() + end;
+			char const *const newline = std::find(first, last, '\n');
+			if (newline != last) {
+				line.assign(first, newline);
+				begin += static_cast<size_t>(newline - first) + 1;
+				return true;
+			}
+			if (end - begin >= maxRequestLine || !fill()) {
+				return false;
+			}
+		}
+	}
+
+	// Calls consume with the size bytes after the request line in pieces as they arrive, false if the connection
+	// ends first
+	template<typename Consume>
+	bool readBody(uint64_t size, Consume &&consume)
+	{
+		while (size != 0) {
+			if (begin == end && !fill()) {
+				return false;
+			}
+			size_t const take = static_cast<size_t>(std::min<uint64_t>(size, end - begin));
+			consume(std::span<char const>(buffer.data() + begin, take));
+			begin += take;
+			size -= take;
+		}
+		return true;
+	}
+
+	bool send(std::string_view text)
+	{
+		while (!text.empty()) {
+			ssize_t const sent = ::send(fd, text.data(), text.size(), MSG_NOSIGNAL);
+			if (sent < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				return false;
+			}
+			text.remove_prefix(static_cast<size_t>(sent));
+		}
+		return true;
+	}
+
+private:
+	// Reads more after what is buffered, moving that to the front first; false at the end of the connection
+	bool fill()
+	{
+		if (begin != 0) {
+			std::copy(buffer.begin() + static_cast<ptrdiff_t>(begin), buffer.begin() + static_cast<ptrdiff_t>(end),
+				buffer.begin());
+			end -= begin;
+			begin = 0;
+		}
+		while (true) {
+			ssize_t const received = ::recv(fd, buffer.data() + end, buffer.size() - end, 0);
+			if (received > 0) {
+				end += static_cast<size_t>(received);
+				return true;
+			}
+			if (received == 0 || errno != EINTR) {
+				return false;
+			}
+		}
+	}
+
+	int fd;
+	std::vector<char> buffer;
+	size_t begin = 0;
+	size_t end = 0;
+};
+
+struct ServerState {
+	ServerState(int listener, ValidationOptions const &options,
+		std::function<bool(std::string const &, ThreadPool *)> const &validate)
+		: listener(listener)
+		, options(options)
+		, validate(validate)
+		, pool(options.threads)
+		// Files of a few blocks or more are worth splitting across the pool, if it has more than one worker
+		, largeFileSize(pool.size() > 1 ? uint64_t {4} * options.blockSize : UINT64_MAX)
+	{
+	}
+
+	int const listener;
+	ValidationOptions const &options;
+	std::function<bool(std::string const &, ThreadPool *)> const &validate;
+	ThreadPool pool;
+	uint64_t const largeFileSize;
+	// Guards clients, the connections being served, and stopping
+	std::mutex mutex;
+	std::vector<int> clients;
+	bool stopping = false;
+};
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point start)
+{
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Answers the requests of one client until it disconnects or sends one that is not understood
+void serveClient(Connection &connection, ServerState &state, VcfValidator &validator)
+{
+	std::string line;
+	std::string response;
+	std::string messages;
+	while (connection.readLine(line)) {
+		Clock::time_point const start = Clock::now();
+		response.clear();
+		std::string_view const request = line;
+		if (request.starts_with("FILE ")) {
+			std::string const path(request.substr(5));
+			std::ostringstream out;
+			bool valid = false;
+			{
+				DiagnosticsRedirect redirect(out);
+				std::error_code error;
+				uint64_t const size = std::filesystem::file_size(path, error);
+				valid = state.validate(path, !error && size >= state.largeFileSize ? &state.pool : nullptr);
+			}
+			appendResult(response, valid, secondsSince(start), out.view(), {}, false);
+		} else if (request.starts_with("DATA ")) {
+			std::string_view const sizeText = request.substr(5);
+			uint64_t size = 0;
+			auto [ptr, ec] = std::from_chars(sizeText.data(), sizeText.data() + sizeText.size(), size);
+			if (ec != std::errc() || ptr != sizeText.data() + sizeText.size()) {
+				connection.send("{\"error\":\"Invalid DATA size\"}\n");
+				return;
+			}
+			validator.reset();
+			if (!connection.readBody(size, [&validator](std::span<char const> piece) { validator.feed(piece); })) {
+				return;
+			}
+			bool const valid = validator.finish();
+			messages.clear();
+			formatErrors(validator.errors(), state.options.maxErrors != 1, messages);
+			appendResult(response, valid, secondsSince(start), messages, validator.errors(), true);
+		} else {
+			connection.send("{\"error\":\"Unknown request, expected FILE or DATA\"}\n");
+			return;
+		}
+		if (!connection.send(response)) {
+			return;
+		}
+	}
+}
+
+// One of the threads taking connections; its VcfValidator keeps its buffers from one request to the next
+void serveConnections(ServerState &state)
+{
+	placeThread(ThreadStage::Main);
+	VcfValidator validator(state.options);
+	while (true) {
+		int const fd = ::accept4(state.listener, nullptr, nullptr, SOCK_CLOEXEC);
+		{
+			std::lock_guard lock(state.mutex);
+			if (state.stopping) {
+				if (fd >= 0) {
+					::close(fd);
+				}
+				return;
+			}
+			if (fd >= 0) {
+				state.clients.push_back(fd);
+			}
+		}
+		if (fd < 0) {
+			if (errno != EINTR && errno != ECONNABORTED) {
+				// Out of descriptors or the like, which a moment may cure
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			}
+			continue;
+		}
+
+		Connection connection(fd);
+		serveClient(connection, state, validator);
+
+		std::lock_guard lock(state.mutex);
+		state.clients.erase(std::find(state.clients.begin(), state.clients.end(), fd));
+		::close(fd);
+	}
+}
+
+// A listening socket bound to path, -1 with a message on diagnostics() if that fails
+int listenAt(std::string const &path)
+{
+	sockaddr_un address {};
+	address.sun_family = AF_UNIX;
+	if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+		diagnostics() << "Invalid socket path: " << path << '\n';
+		return -1;
+	}
+	std::copy(path.begin(), path.end(), address.sun_path);
+	auto const *const name = reinterpret_cast<sockaddr const *>(&address);
+
+	int const fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		diagnostics() << "Failed to create socket: " << std::strerror(errno) << '\n';
+		return -1;
+	}
+	// A socket file nobody accepts on is left from a server that did not shut down
+	if (std::filesystem::is_socket(path)) {
+		if (::connect(fd, name, sizeof(address)) == 0) {
+			diagnostics() << "Socket already in use: " << path << '\n';
+			::close(fd);
+			return -1;
+		}
+		::unlink(path.c_str());
+	}
+	if (::bind(fd, name, sizeof(address)) != 0 || ::listen(fd, SOMAXCONN) != 0) {
+		diagnostics() << "Failed to listen on socket: " << path << ": " << std::strerror(errno) << '\n';
+		::close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+} // namespace
+
+bool serveValidation(std::string const &socketPath, ValidationOptions const &options,
+	std::function<bool(std::string const &, ThreadPool *)> const &validate)
+{
+	// Blocked before any thread starts so that every thread inherits the mask and only sigwait() below takes them
+	sigset_t signals;
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGINT);
+	sigaddset(&signals, SIGTERM);
+	sigset_t previous;
+	pthread_sigmask(SIG_BLOCK, &signals, &previous);
+
+	int const listener = listenAt(socketPath);
+	if (listener < 0) {
+		pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+		return false;
+	}
+
+	{
+		ServerState state(listener, options, validate);
+		std::vector<std::thread> servers;
+		for (unsigned i = 0; i < state.pool.size(); ++i) {
+			servers.emplace_back(serveConnections, std::ref(state));
+		}
+		diagnostics() << "Listening on " << socketPath << '\n';
+
+		int signal = 0;
+		sigwait(&signals, &signal);
+		{
+			std::lock_guard lock(state.mutex);
+			state.stopping = true;
+			for (int const client : state.clients) {
+				::shutdown(client, SHUT_RDWR);
+			}
+		}
+		// Wakes up the threads blocked in accept()
+		::shutdown(listener, SHUT_RDWR);
+		for (auto &server : servers) {
+			server.join();
+		}
+	}
+	::close(listener);
+	::unlink(socketPath.c_str());
+	pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+	return true;
+}
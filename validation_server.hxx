@@ -0,0 +1,30 @@
+#pragma once
+
+#include "validation_options.hxx"
+
+#include <functional>
+#include <string>
+
+class ThreadPool;
+
+// --serve: validates VCFs for clients of a Unix stream socket until SIGINT or SIGTERM, so that each request finds
+// the validator's threads, pools and per-thread buffers already set up. A connection sends any number of requests,
+// each answered by one line of JSON:
+//
+//   FILE <path>\n             validates the file at path, like the command line
+//   DATA <size>\n<size bytes> validates size bytes of uncompressed VCF text, fed to a VcfValidator as they arrive
+//
+//   {"valid":false,"seconds":0.000127,"messages":["Invalid POS field (not an integer): x"],"errors":[{"line":12,
+//   "column":2,"message":"Invalid POS field (not an integer): x"}]}
+//
+// messages are the lines the command line would print, with their line:column in front under --max-errors other
+// than 1; only DATA answers have the errors as objects too. An
+// unknown or malformed request is answered with {"error":"..."} and the connection closed.
+//
+// Connections are served by options.threads threads of their own, each with its own VcfValidator. Files under
+// four blocks are validated whole on the thread of their connection with validate(path, nullptr), larger ones with
+// validate(path, pool) so that their blocks spread over a pool of options.threads workers shared by all of them.
+// Returns false, with the reason on diagnostics(), if the socket cannot be set up; a stale socket file at
+// socketPath with no server behind it is replaced.
+bool serveValidation(std::string const &socketPath, ValidationOptions const &options,
+	std::function<bool(std::string const &, ThreadPool *)> const &validate);
@@ -0,0 +1,173 @@
+#include "validation_stats.hxx"
+
+#include <chrono>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+
+namespace stats_detail {
+bool enabled = false;
+uint64_t (*allocationCounter)() = nullptr;
+} // namespace stats_detail
+
+namespace {
+
+struct Totals {
+	std::array<uint64_t, statsStageCount> ticks {};
+	std::array<uint64_t, statsStageCount> calls {};
+	std::array<uint64_t, statsStageCount> allocations {};
+	std::array<uint64_t, statsCounterCount> counts {};
+
+	void add(Totals const &other)
+	{
+		for (size_t i = 0; i < statsStageCount; ++i) {
+			ticks[i] += other.ticks[i];
+			calls[i] += other.calls[i];
+			allocations[i] += other.allocations[i];
+		}
+		for (size_t i = 0; i < statsCounterCount; ++i) {
+			counts[i] += other.counts[i];
+		}
+	}
+};
+
+std::mutex mergedMutex;
+Totals merged;
+
+// Folded into merged when its thread exits
+struct ThreadTotals : Totals {
+	ThreadTotals() = default;
+	ThreadTotals(ThreadTotals const &) = delete;
+	ThreadTotals &operator=(ThreadTotals const &) = delete;
+
+	~ThreadTotals()
+	{
+		std::lock_guard lock(mergedMutex);
+		merged.add(*this);
+	}
+};
+
+thread_local ThreadTotals threadTotals;
+
+uint64_t startTicks = 0;
+std::chrono::steady_clock::time_point startTime;
+
+constexpr std::string_view stageNames[statsStageCount] = {
+	"decompress",
+	"read",
+	"header_lines",
+	"data_lines",
+	"format_and_samples",
+	"write",
+};
+
+constexpr std::string_view counterNames[statsCounterCount] = {"bytes", "records", "samples"};
+
+double megabytesPerSecond(uint64_t bytes, double seconds)
+{
+	return seconds > 0 ? static_cast<double>(bytes) / 1e6 / seconds : 0;
+}
+
+} // namespace
+
+void enableStats()
+{
+	startTime = std::chrono::steady_clock::now();
+	startTicks = readTicks();
+	stats_detail::enabled = true;
+}
+
+void countAllocationsWith(uint64_t (*counter)())
+{
+	stats_detail::allocationCounter = counter;
+}
+
+void addStageTicks(StatsStage stage, uint64_t ticks, uint64_t allocations)
+{
+	auto const index = static_cast<size_t>(stage);
+	threadTotals.ticks[index] += ticks;
+	++threadTotals.calls[index];
+	threadTotals.allocations[index] += allocations;
+}
+
+void addStatsCount(StatsCounter counter, uint64_t amount)
+{
+	threadTotals.counts[static_cast<size_t>(counter)] += amount;
+}
+
+StatsReport collectStats()
+{
+	Totals totals;
+	{
+		std::lock_guard lock(mergedMutex);
+		totals = merged;
+	}
+	totals.add(threadTotals);
+
+	StatsReport report;
+	uint64_t const elapsedTicks = readTicks() - startTicks;
+	report.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	// Calibrate the tick rate against the steady clock over the whole run
+	double const secondsPerTick = elapsedTicks != 0 ? report.wallSeconds / static_cast<double>(elapsedTicks) : 0;
+	report.counts = totals.counts;
+	report.stageCalls = totals.calls;
+	report.allocationsCounted = stats_detail::allocationCounter != nullptr;
+	report.stageAllocations = totals.allocations;
+	for (size_t i = 0; i < statsStageCount; ++i) {
+		report.stageSeconds[i] = static_cast<double>(totals.ticks[i]) * secondsPerTick;
+	}
+	return report;
+}
+
+void printStats(std::ostream &out, StatsReport const &report)
+{
+	uint64_t const bytes = report.counts[static_cast<size_t>(StatsCounter::Bytes)];
+	uint64_t const records = report.counts[static_cast<size_t>(StatsCounter::Records)];
+	auto const flags = out.flags();
+	out << std::fixed << std::setprecision(3);
+	out << "wall time:  " << report.wallSeconds << " s\n"
+		<< "bytes:      " << bytes << " (" << megabytesPerSecond(bytes, report.wallSeconds) << " MB/s)\n"
+		<< "records:    " << records << " ("
+		<< (report.wallSeconds > 0 ? static_cast<double>(records) / report.wallSeconds : 0) << " records/s)\n"
+		<< "samples:    " << report.counts[static_cast<size_t>(StatsCounter::Samples)] << '\n';
+	out << std::left << std::setw(20) << "stage" << std::right << std::setw(12) << "calls" << std::setw(12)
+		<< "seconds" << std::setw(12) << "MB/s";
+	if (report.allocationsCounted) {
+		out << std::setw(12) << "allocs";
+	}
+	out << '\n';
+	for (size_t i = 0; i < statsStageCount; ++i) {
+		out << std::left << std::setw(20) << stageNames[i] << std::right << std::setw(12) << report.stageCalls[i]
+			<< std::setw(12) << report.stageSeconds[i] << std::setw(12)
+			<< megabytesPerSecond(bytes, report.stageSeconds[i]);
+		if (report.allocationsCounted) {
+			out << std::setw(12) << report.stageAllocations[i];
+		}
+		out << '\n';
+	}
+	out.flags(flags);
+}
+
+void printStatsJson(std::ostream &out, StatsReport const &report)
+{
+	auto const flags = out.flags();
+	out << std::setprecision(9);
+	out << "{\"wall_seconds\":" << report.wallSeconds;
+	for (size_t i = 0; i < statsCounterCount; ++i) {
+		out << ",\"" << counterNames[i] << "\":" << report.counts[i];
+	}
+	out << ",\"megabytes_per_second\":"
+		<< megabytesPerSecond(report.counts[static_cast<size_t>(StatsCounter::Bytes)], report.wallSeconds);
+	out << ",\"stages\":{";
+	for (size_t i = 0; i < statsStageCount; ++i) {
+		out << (i != 0 ? "," : "") << '"' << stageNames[i] << "\":{\"calls\":" << report.stageCalls[i]
+			<< ",\"seconds\":" << report.stageSeconds[i];
+		if (report.allocationsCounted) {
+			out << ",\"allocations\":" << report.stageAllocations[i];
+		}
+		out << '}';
+	}
+	out << "}}\n";
+	out.flags(flags);
+}
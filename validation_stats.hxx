@@ -0,0 +1,117 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+#if defined(__x86_64__) || defined(__i386__)
+#	include <x86intrin.h>
+#else
+#	include <chrono>
+#endif
+
+// Per-stage timers and counters behind --stats. Every thread accumulates into its own counters, which are merged
+// when the thread exits; with stats disabled a timer is a single test of a global flag.
+
+enum class StatsStage
+{
+	Decompress, // Inflating BGZF batches, or plain gzip ahead of validation
+	Read, // Pulling lines or blocks from the input, including streaming inflation of plain gzip
+	HeaderLines, // validateHeaderLine
+	DataLines, // checkDataLines, including FORMAT and sample checks
+	FormatAndSamples, // checkFormatAndSamples
+	Write, // --filter-out and --rejects output, BGZF compression included
+};
+constexpr size_t statsStageCount = 6;
+
+enum class StatsCounter
+{
+	Bytes, // Decompressed input
+	Records,
+	Samples,
+};
+constexpr size_t statsCounterCount = 3;
+
+namespace stats_detail {
+extern bool enabled;
+extern uint64_t (*allocationCounter)();
+} // namespace stats_detail
+
+// Turns collection on, must be called before the threads doing the work are started
+void enableStats();
+// Counts the heap allocations of every stage with counter, which returns the calling thread's allocations so far.
+// Only programs that replace operator new can count them (allocation_counter.hxx), so the library leaves it unset.
+void countAllocationsWith(uint64_t (*counter)());
+
+inline bool statsEnabled()
+{
+	return stats_detail::enabled;
+}
+
+// Timestamp counter where the CPU has one, steady_clock nanoseconds elsewhere
+inline uint64_t readTicks()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+void addStageTicks(StatsStage stage, uint64_t ticks, uint64_t allocations);
+void addStatsCount(StatsCounter counter, uint64_t amount);
+
+inline void countStats(StatsCounter counter, uint64_t amount)
+{
+	if (statsEnabled()) {
+		addStatsCount(counter, amount);
+	}
+}
+
+// Adds the time spent in its scope to a stage
+class ScopedStageTimer {
+public:
+	explicit ScopedStageTimer(StatsStage stage)
+		: stage(stage)
+		, start(statsEnabled() ? readTicks() : 0)
+		, startAllocations(start != 0 ? currentAllocations() : 0)
+	{
+	}
+
+	~ScopedStageTimer()
+	{
+		if (start != 0) {
+			addStageTicks(stage, readTicks() - start, currentAllocations() - startAllocations);
+		}
+	}
+
+	ScopedStageTimer(ScopedStageTimer const &) = delete;
+	ScopedStageTimer &operator=(ScopedStageTimer const &) = delete;
+
+private:
+	static uint64_t currentAllocations()
+	{
+		return stats_detail::allocationCounter != nullptr ? stats_detail::allocationCounter() : 0;
+	}
+
+	StatsStage stage;
+	uint64_t start;
+	uint64_t startAllocations;
+};
+
+struct StatsReport {
+	double wallSeconds = 0;
+	std::array<uint64_t, statsCounterCount> counts {};
+	// Summed over all threads, so with worker threads a stage can exceed the wall time
+	std::array<double, statsStageCount> stageSeconds {};
+	std::array<uint64_t, statsStageCount> stageCalls {};
+	// Heap allocations made inside each stage, all zero unless counted (countAllocationsWith)
+	bool allocationsCounted = false;
+	std::array<uint64_t, statsStageCount> stageAllocations {};
+};
+
+// Totals of the exited threads plus the calling thread, call once the worker threads are joined
+StatsReport collectStats();
+void printStats(std::ostream &out, StatsReport const &report);
+void printStatsJson(std::ostream &out, StatsReport const &report);
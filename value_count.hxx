@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+// Number= of an INFO or FORMAT definition
+struct ValueCount {
+	enum class Kind : uint8_t
+	{
+		Fixed,
+		PerAlternateAllele, // A
+		PerAllele, // R
+		PerGenotype, // G
+		Unknown, // . (and U)
+	};
+
+	Kind kind = Kind::Unknown;
+	int32_t count = 0; // For Fixed
+};
+
+// Unordered genotypes of ploidy alleles each drawn from alleles, the REF allele included: the number of values of a
+// Number=G key, alleles * (alleles + 1) / 2 for a diploid sample
+constexpr uint64_t genotypeCount(uint64_t alleles, uint32_t ploidy)
+{
+	uint64_t count = 1;
+	for (uint32_t k = 1; k <= ploidy; ++k) {
+		count = count * (alleles + k - 1) / k;
+	}
+	return count;
+}
+
+// Values a key of this Number has in a record with altAlleles ALT alleles, for Number=G in a sample of ploidy;
+// 0 if any count is allowed
+constexpr uint64_t expectedValueCount(ValueCount number, uint32_t altAlleles, uint32_t ploidy = 2)
+{
+	switch (number.kind) {
+	case ValueCount::Kind::Fixed:
+		return number.count > 0 ? static_cast<uint64_t>(number.count) : 0;
+	case ValueCount::Kind::PerAlternateAllele:
+		return altAlleles;
+	case ValueCount::Kind::PerAllele:
+		return uint64_t {altAlleles} + 1;
+	case ValueCount::Kind::PerGenotype:
+		return genotypeCount(uint64_t {altAlleles} + 1, ploidy);
+	case ValueCount::Kind::Unknown:
+		break;
+	}
+	return 0;
+}
@@ -0,0 +1,855 @@
+#include "vcf_validation.hxx"
+
+#include "char_class.hxx"
+#include "delimiter_scan.hxx"
+#include "error_sink.hxx"
+#include "format_checks.hxx"
+#include "header_model.hxx"
+#include "info_checks.hxx"
+#include "number_syntax.hxx"
+#include "record_order.hxx"
+#include "validation_stats.hxx"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace {
+
+thread_local std::ostream *diagnosticsStream = nullptr;
+
+} // namespace
+
+std::ostream &diagnostics()
+{
+	return diagnosticsStream != nullptr ? *diagnosticsStream : std::cerr;
+}
+
+DiagnosticsRedirect::DiagnosticsRedirect(std::ostream &target)
+	: previous(diagnosticsStream)
+{
+	diagnosticsStream = &target;
+}
+
+DiagnosticsRedirect::~DiagnosticsRedirect()
+{
+	diagnosticsStream = previous;
+}
+
+uint32_t countAltAlleles(std::string_view alt)
+{
+	// Single-pass scanner for the ALT grammar ^([ACGTN*]+|<[^>]+>)(,[ACGTN*]+|,<[^>]+>)*$
+	// Every allele is either a non-empty run of bases/'*' or a non-empty symbolic allele in angle brackets
+	size_t i = 0;
+	size_t const size = alt.size();
+	uint32_t alleles = 0;
+	while (true) {
+		if (i == size) {
+			return 0; // Empty allele
+		}
+
+		if (alt[i] == '<') {
+			size_t const close = alt.find('>', i + 1);
+			if (close == std::string_view::npos || close == i + 1) {
+				return 0; // Unterminated or empty symbolic allele
+			}
+			i = close + 1;
+		} else {
+			size_t const start = i;
+			i += char_class::AltBases::span(alt.substr(i));
+			if (i == start) {
+				return 0;
+			}
+		}
+		++alleles;
+
+		if (i == size) {
+			return alleles;
+		}
+		if (alt[i] != ',') {
+			return 0;
+		}
+		++i; // Move past the allele separator
+	}
+}
+
+bool isValidAlt(std::string_view alt)
+{
+	return countAltAlleles(alt) != 0;
+}
+
+namespace {
+
+// Hand-written matchers for the meta-information line grammars. Each one consumes its part of the line from the
+// front of rest and returns false, leaving rest unspecified, when the line does not match.
+
+// Consumes prefix
+bool consume(std::string_view &rest, std::string_view prefix)
+{
+	if (!rest.starts_with(prefix)) {
+		return false;
+	}
+	rest.remove_prefix(prefix.size());
+	return true;
+}
+
+// [^,]+, the ID of a structured line up to the comma that ends it; the comma is left in rest
+bool consumeId(std::string_view &rest, std::string_view &id)
+{
+	size_t const comma = rest.find(',');
+	if (comma == 0 || comma == std::string_view::npos) {
+		return false;
+	}
+	id = rest.substr(0, comma);
+	rest.remove_prefix(comma);
+	return true;
+}
+
+// "[^"]+", a non-empty quoted value after its opening quote, including the closing quote
+bool consumeQuoted(std::string_view &rest, std::string_view &value)
+{
+	size_t const quote = rest.find('"');
+	if (quote == 0 || quote == std::string_view::npos) {
+		return false;
+	}
+	value = rest.substr(0, quote);
+	rest.remove_prefix(quote + 1);
+	return true;
+}
+
+bool isDigits(std::string_view text)
+{
+	return !text.empty() && std::ranges::all_of(text, [](char c) { return c >= '0' && c <= '9'; });
+}
+
+// [\.\dAGRU]|-?\d+
+bool parseNumber(std::string_view text, ValueCount &number)
+{
+	if (text.size() == 1) {
+		switch (text[0]) {
+		case 'A':
+			number.kind = ValueCount::Kind::PerAlternateAllele;
+			return true;
+		case 'R':
+			number.kind = ValueCount::Kind::PerAllele;
+			return true;
+		case 'G':
+			number.kind = ValueCount::Kind::PerGenotype;
+			return true;
+		case '.':
+		case 'U':
+			number.kind = ValueCount::Kind::Unknown;
+			return true;
+		default:
+			break;
+		}
+	}
+	if (!isDigits(text.starts_with('-') ? text.substr(1) : text)) {
+		return false;
+	}
+	number.kind = ValueCount::Kind::Fixed;
+	// Counts beyond int32_t are syntactically fine, they just cannot be met
+	auto const [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), number.count);
+	if (ec == std::errc::result_out_of_range) {
+		number.count = text.starts_with('-') ? INT32_MIN : INT32_MAX;
+	}
+	return true;
+}
+
+bool parseType(std::string_view text, ValueType &type)
+{
+	static constexpr std::pair<std::string_view, ValueType> types[] = {
+		{"Integer", ValueType::Integer},
+		{"Float", ValueType::Float},
+		{"Flag", ValueType::Flag},
+		{"Character", ValueType::Character},
+		{"String", ValueType::String},
+	};
+	auto const found = std::ranges::find(types, text, &std::pair<std::string_view, ValueType>::first);
+	if (found == std::end(types)) {
+		return false;
+	}
+	type = found->second;
+	return true;
+}
+
+// (,[^,]+="[^"]+")*>, the extra attributes closing an INFO or FORMAT line. A key may itself contain '="', so every
+// '="' before the next comma is a candidate end of the key; positions already known not to lead to a match are
+// not tried again.
+bool matchesExtraAttributes(std::string_view text)
+{
+	std::vector<bool> tried(text.size() + 1);
+	std::vector<size_t> pending {0};
+	while (!pending.empty()) {
+		size_t const at = pending.back();
+		pending.pop_back();
+		if (tried[at]) {
+			continue;
+		}
+		tried[at] = true;
+
+		if (text.substr(at) == ">") {
+			return true;
+		}
+		if (at == text.size() || text[at] != ',') {
+			continue;
+		}
+		size_t const keyEnd = std::min(text.find(',', at + 1), text.size());
+		for (size_t equals = text.find("=\"", at + 2); equals < keyEnd; equals = text.find("=\"", equals + 1)) {
+			size_t const quote = text.find('"', equals + 2);
+			if (quote != std::string_view::npos && quote != equals + 2) {
+				pending.push_back(quote + 1);
+			}
+		}
+	}
+	return false;
+}
+
+// ##INFO=< or ##FORMAT=< already consumed:
+// ID=[^,]+,Number=([\.\dAGRU]|-?\d+),Type=(Integer|Float|Flag|Character|String),Description="[^"]+"(,[^,]+="[^"]+")*>
+bool parseFieldDefinition(std::string_view rest, std::string_view &id, FieldDefinition &definition)
+{
+	std::string_view description;
+	if (!consume(rest, "ID=") || !consumeId(rest, id) || !consume(rest, ",Number=")) {
+		return false;
+	}
+	size_t const numberEnd = rest.find(',');
+	if (numberEnd == std::string_view::npos || !parseNumber(rest.substr(0, numberEnd), definition.number)) {
+		return false;
+	}
+	rest.remove_prefix(numberEnd);
+	if (!consume(rest, ",Type=")) {
+		return false;
+	}
+	size_t const typeEnd = rest.find(',');
+	if (typeEnd == std::string_view::npos || !parseType(rest.substr(0, typeEnd), definition.type)) {
+		return false;
+	}
+	rest.remove_prefix(typeEnd);
+	if (!consume(rest, ",Description=\"") || !consumeQuoted(rest, description)) {
+		return false;
+	}
+	definition.description = description;
+	return matchesExtraAttributes(rest);
+}
+
+// ##FILTER=< or ##ALT=< already consumed: ID=[^,]+,Description="[^"]+">
+bool parseDescribedId(std::string_view rest, std::string_view &id)
+{
+	std::string_view description;
+	return consume(rest, "ID=") && consumeId(rest, id) && consume(rest, ",Description=\"")
+		&& consumeQuoted(rest, description) && rest == ">";
+}
+
+} // namespace
+
+bool validateFileFormatLine(std::string_view line, HeaderModel *header)
+{
+	// ##fileformat=VCFv\d+\.\d+
+	std::string_view rest = line;
+	bool valid = consume(rest, "##fileformat=");
+	std::string_view const version = rest;
+	if (valid && consume(rest, "VCFv")) {
+		size_t const dot = rest.find('.');
+		valid = dot != std::string_view::npos && isDigits(rest.substr(0, dot)) && isDigits(rest.substr(dot + 1));
+	} else {
+		valid = false;
+	}
+	if (!valid) {
+		reportError(ErrorCode::InvalidFileFormat, line);
+		return false;
+	}
+	if (header != nullptr) {
+		header->setFileFormat(version);
+	}
+	return true;
+}
+
+bool validateContigLine(std::string_view line, HeaderModel *header)
+{
+	// ##contig=<ID=[^,]+(,length=\d+)?(,.*)?>
+	// Without a comma the ID runs up to the closing '>'; with one, the ID ends at the first comma and what follows up
+	// to the '>' is any attribute list without line breaks.
+	std::string_view rest = line;
+	bool valid = consume(rest, "##contig=<ID=") && rest.ends_with('>');
+	std::string_view id;
+	std::string_view attributes;
+	if (valid) {
+		rest.remove_suffix(1);
+		size_t const comma = rest.find(',');
+		id = rest.substr(0, comma);
+		if (comma != std::string_view::npos) {
+			attributes = rest.substr(comma);
+			valid = attributes.find_first_of("\r\n") == std::string_view::npos;
+		}
+		valid = valid && !id.empty();
+	}
+	if (!valid) {
+		reportError(ErrorCode::InvalidContigLine, line);
+		return false;
+	}
+
+	if (header != nullptr) {
+		ContigDefinition contig {std::string(id), std::nullopt};
+		forEachField<','>(attributes, [&contig](std::string_view attribute) {
+			uint64_t length = 0;
+			if (attribute.starts_with("length=") && isDigits(attribute.substr(7))) {
+				auto const [ptr, ec] = std::from_chars(attribute.data() + 7, attribute.data() + attribute.size(), length);
+				if (ec == std::errc()) {
+					contig.length = length;
+				}
+				return false;
+			}
+			return true;
+		});
+		header->addContig(std::move(contig));
+	}
+	return true;
+}
+
+bool validateAltLine(std::string_view line)
+{
+	std::string_view rest = line;
+	std::string_view id;
+	if (!consume(rest, "##ALT=<") || !parseDescribedId(rest, id)) {
+		reportError(ErrorCode::InvalidAltLine, line);
+		return false;
+	}
+	return true;
+}
+
+bool validateSampleOrPedigreeLine(std::string_view line)
+{
+	// Basic structure check; can be more specific based on VCF version and use case
+	if (line.starts_with("##SAMPLE=") || line.starts_with("##PEDIGREE=")) {
+		return true; // Assuming well-formed for this example
+	}
+	reportError(ErrorCode::InvalidSampleOrPedigreeLine, line);
+	return false;
+}
+
+bool validateHeaderLine(std::string_view line, HeaderModel *header)
+{
+	ScopedStageTimer timer(StatsStage::HeaderLines);
+
+	std::string_view rest = line;
+	if (consume(rest, "##INFO=<") || consume(rest, "##FORMAT=<")) {
+		bool const isInfo = line[2] == 'I';
+		std::string_view id;
+		FieldDefinition definition;
+		if (!parseFieldDefinition(rest, id, definition)) {
+			reportError(ErrorCode::InvalidInfoOrFormatLine, line);
+			return false;
+		}
+		if (header != nullptr) {
+			isInfo ? header->addInfo(id, std::move(definition)) : header->addFormat(id, std::move(definition));
+		}
+		return true;
+	} else if (line.starts_with("##INFO=") || line.starts_with("##FORMAT=")) {
+		reportError(ErrorCode::InvalidInfoOrFormatLine, line);
+		return false;
+	} else if (line.starts_with("##FILTER=")) {
+		std::string_view id;
+		if (!consume(rest, "##FILTER=<") || !parseDescribedId(rest, id)) {
+			reportError(ErrorCode::InvalidFilterLine, line);
+			return false;
+		}
+		if (header != nullptr) {
+			header->addFilter(id);
+		}
+		return true;
+	} else if (line.starts_with("##fileformat=")) {
+		return validateFileFormatLine(line, header);
+	} else if (line.starts_with("##contig=")) {
+		return validateContigLine(line, header);
+	} else if (line.starts_with("##ALT=")) {
+		return validateAltLine(line);
+	} else if (line.starts_with("##SAMPLE=") || line.starts_with("##PEDIGREE=")) {
+		return validateSampleOrPedigreeLine(line);
+	}
+
+	if (line.starts_with("##")) {
+		// Optionally, perform a basic structure check here, if necessary
+		return true; // Accepts any well-formed header lines not covered by specific checks
+	}
+
+	reportError(ErrorCode::UnknownHeaderFormat, line);
+	return false;
+}
+
+bool checkTitleLine(std::string_view line, HeaderModel *header)
+{
+	static constexpr std::string_view requiredColumns[] = {
+		"#CHROM", "POS", "ID", "REF", "ALT", "QUAL", "FILTER", "INFO"};
+	// Columns are told apart by runs of whitespace, as reading them with operator>> did
+	constexpr std::string_view whitespace = " \t\n\v\f\r";
+	std::vector<std::string_view> columns;
+	size_t start = line.find_first_not_of(whitespace);
+	while (start != std::string_view::npos) {
+		size_t const end = std::min(line.find_first_of(whitespace, start), line.size());
+		columns.push_back(line.substr(start, end - start));
+		start = line.find_first_not_of(whitespace, end);
+	}
+	if (columns.size() < std::size(requiredColumns)) {
+		reportError(ErrorCode::InsufficientTitleColumns);
+		return false;
+	}
+	if (!std::equal(std::begin(requiredColumns), std::end(requiredColumns), columns.begin())) {
+		reportError(ErrorCode::InvalidTitleLine, line);
+		return false;
+	}
+
+	// Sample columns follow the ninth, FORMAT
+	size_t const formatIndex = std::size(requiredColumns);
+	if (header != nullptr) {
+		header->setSamples(columns.size() > formatIndex
+				? std::vector<std::string>(columns.begin() + formatIndex + 1, columns.end())
+				: std::vector<std::string>());
+		if (!header->unknownSamples().empty()) {
+			reportError(ErrorCode::UnknownSample, header->unknownSamples().front());
+			return false;
+		}
+	}
+	return true;
+}
+
+std::vector<std::string_view> split(std::string_view str, char delimiter)
+{
+	std::vector<std::string_view> result;
+	size_t start = 0;
+	size_t end = 0;
+
+	while ((end = str.find(delimiter, start)) != std::string_view::npos) {
+		// Add a string_view of the token to the result
+		result.emplace_back(str.substr(start, end - start));
+		start = end + 1; // Move past the delimiter
+	}
+	// Add the last token after the final delimiter
+	result.emplace_back(str.substr(start));
+
+	return result;
+}
+
+bool isValidBase(std::string_view base)
+{
+	return char_class::Bases::all(base);
+}
+
+bool isValidGenotype(std::string_view gt)
+{
+	if (gt == ".") {
+		return true; // Handle missing data
+	}
+
+	// Alleles are digit runs joined by single separators, so a separator needs a digit before it and the last
+	// character must be a digit
+	bool seenDigit = false;
+	for (char c : gt) {
+		if (char_class::Digits::contains(c)) {
+			seenDigit = true;
+		} else if (char_class::GenotypeSeparators::contains(c) && seenDigit) {
+			seenDigit = false;
+		} else {
+			return false;
+		}
+	}
+	return seenDigit;
+}
+
+bool isNonNegativeInteger(std::string_view str)
+{
+	return number_syntax::startsWithNonNegative<int>(str);
+}
+
+bool isListOfNonNegativeIntegers(std::string_view str)
+{
+	return forEachField<','>(str, isNonNegativeInteger);
+}
+
+bool isFloat(std::string_view str)
+{
+	if (number_syntax::isShortDecimal<true>(str)) {
+		return true;
+	}
+	// Exponents, infinities and long mantissas, where only the conversion tells whether the value is in range
+	float value = 0.0f;
+	auto result = std::from_chars(str.data(), str.data() + str.size(), value);
+	return result.ec == std::errc();
+}
+
+bool isBoolean(std::string_view value)
+{
+	return value == "0" || value == "1";
+}
+
+bool isNumericChromosome(std::string_view chrom)
+{
+	if (chrom.empty()) {
+		return false;
+	}
+
+	// Check for numeric chromosomes (1-22)
+	int num = 0;
+	auto [ptr, ec] = std::from_chars(chrom.data(), chrom.data() + chrom.size(), num);
+	return ec == std::errc() && num >= 1 && num <= 22;
+}
+
+bool isHumanChromosome(std::string_view chrom)
+{
+	// Handle common prefixes
+	if (chrom.starts_with("chr")) {
+		chrom.remove_prefix(3); // Remove "chr" prefix
+	}
+
+	// Check for standard and sex chromosomes
+	if (isNumericChromosome(chrom) || chrom == "X" || chrom == "Y" || chrom == "MT" || chrom == "M") {
+		return true;
+	}
+
+	// Check for unplaced or alternative sequences like 'chrUn_' or 'KI'
+	if (chrom.starts_with("Un_") || chrom.starts_with("KI") || chrom.contains("_KI")) {
+		return true;
+	}
+
+	return false;
+}
+
+bool checkFormatAndSamples(
+	std::span<std::string_view const> fields, size_t formatIndex, HeaderModel const *header, uint32_t altAlleles)
+{
+	if (header != nullptr && header->sampleSelection().sitesOnly) {
+		return true;
+	}
+	if (formatIndex >= fields.size()) {
+		reportError(ErrorCode::FormatMissing);
+		return false;
+	}
+	if (header != nullptr && !header->checksSamplesOf(fields[0], fields[1])) {
+		return true;
+	}
+	ScopedStageTimer timer(StatsStage::FormatAndSamples);
+
+	// Per-thread state keeps its capacity and the resolved FORMAT columns from record to record
+	thread_local FormatDispatchCache formatCache;
+	thread_local std::vector<std::vector<std::string_view>> columns;
+	ResolvedFormat const &resolved = formatCache.resolve(fields[formatIndex], header);
+	auto const &formatChecks = resolved.checks;
+	if (formatIndex + 1 >= fields.size()) {
+		return true; // No sample columns
+	}
+
+	size_t const keyCount = formatChecks.size();
+	if (columns.size() < keyCount) {
+		columns.resize(keyCount);
+	}
+	for (size_t j = 0; j < keyCount; ++j) {
+		columns[j].clear();
+	}
+
+	// One pass over the sample columns files every cell under its FORMAT key. It stops at the first sample whose
+	// sub-field count does not match, only the samples before it are complete.
+	std::string_view const samples = fields[formatIndex + 1];
+	auto const selected = header != nullptr ? header->selectedSamples() : std::span<uint32_t const>();
+	size_t completeSamples = 0;
+	bool allMatch = true;
+	if (selected.empty()) {
+		size_t cell = 0;
+		size_t start = 0;
+		auto addCell = [&](size_t end) {
+			if (cell < keyCount) {
+				columns[cell].push_back(samples.substr(start, end - start));
+			}
+			++cell;
+			start = end + 1;
+		};
+		allMatch = forEachDelimiter<'\t', ':'>(samples, [&](size_t offset) {
+			addCell(offset);
+			if (samples[offset] == ':') {
+				return true;
+			}
+			if (cell != keyCount) {
+				return false;
+			}
+			++completeSamples;
+			cell = 0;
+			return true;
+		}) && (addCell(samples.size()), cell == keyCount);
+		if (allMatch) {
+			++completeSamples;
+		}
+	} else {
+		// --samples: only the tabs are found up to the last selected sample, the columns in between are not split
+		size_t column = 0;
+		forEachField<'\t'>(samples, [&](std::string_view sample) {
+			if (column++ != selected[completeSamples]) {
+				return true;
+			}
+			size_t cell = 0;
+			forEachField<':'>(sample, [&](std::string_view value) {
+				if (cell < keyCount) {
+					columns[cell].push_back(value);
+				}
+				++cell;
+				return true;
+			});
+			allMatch = cell == keyCount;
+			return allMatch && ++completeSamples < selected.size();
+		});
+	}
+	countStats(StatsCounter::Samples, completeSamples);
+
+	// Validate column by column and report the failure the sample-by-sample order would have hit first: the
+	// lowest sample, then the lowest key within it. Later keys only need to look at samples before that one.
+	size_t firstInvalidSample = completeSamples;
+	FormatKeyCheck const *invalidCheck = nullptr;
+	std::string_view invalidValue;
+	// Keys declared Number=A, R or G also need as many values as the record's alleles give
+	auto const genotypes = resolved.genotypeKey != ResolvedFormat::npos
+		? std::span<std::string_view const>(columns[resolved.genotypeKey])
+		: std::span<std::string_view const>();
+	for (size_t j = 0; j < keyCount; ++j) {
+		FormatKeyCheck const *keyCheck = formatChecks[j];
+		if (keyCheck == nullptr) {
+			continue;
+		}
+		auto const cells = std::span<std::string_view const>(columns[j]).first(firstInvalidSample);
+		size_t invalid = keyCheck->checkColumn != nullptr ? keyCheck->checkColumn(cells) : cells.size();
+		ValueCount const number = resolved.numbers[j];
+		if (number.kind != ValueCount::Kind::Unknown) {
+			invalid = firstMiscountedCell(cells.first(invalid), number, altAlleles, genotypes);
+		}
+		if (invalid < firstInvalidSample) {
+			firstInvalidSample = invalid;
+			invalidCheck = keyCheck;
+			invalidValue = cells[invalid];
+		}
+	}
+
+	// Samples are numbered by their column, not their place in the selection
+	auto sampleNumber = [&selected](size_t sample) { return selected.empty() ? sample : selected[sample]; };
+	if (invalidCheck != nullptr) {
+		reportSampleError(sampleNumber(firstInvalidSample), invalidCheck->key, invalidCheck->message, invalidValue);
+		return false;
+	}
+	if (!allMatch) {
+		reportError(ErrorCode::SampleFieldCountMismatch, {}, sampleColumn(sampleNumber(completeSamples)));
+		return false;
+	}
+	return true;
+}
+
+int stringViewToInt(std::string_view sv)
+{
+	int value = 0;
+	auto [ptr, ec] = std::from_chars(sv.data(), sv.data() + sv.size(), value);
+	if (ec == std::errc::invalid_argument || ec == std::errc::result_out_of_range) {
+		throw std::invalid_argument("Conversion error");
+	}
+	return value;
+}
+
+float stringViewToFloat(std::string_view sv)
+{
+	float value = 0;
+	auto [ptr, ec] = std::from_chars(sv.data(), sv.data() + sv.size(), value);
+	if (ec == std::errc::invalid_argument || ec == std::errc::result_out_of_range) {
+		throw std::invalid_argument("Conversion error");
+	}
+	return value;
+}
+
+bool validateBodyLine(
+	std::string_view line, HeaderModel const *header, RecordOrder *order, ValidationProfile profile)
+{
+	// Meta-information lines are still accepted after the column header line, the model stays as the header built it
+	if (line.starts_with("##")) {
+		return validateHeaderLine(line);
+	}
+	return checkDataLines(line, header, order, profile);
+}
+
+namespace {
+
+// Primary assembly chromosome lengths of GRCh38, with or without the "chr" prefix
+std::optional<uint64_t> grch38Length(std::string_view chrom)
+{
+	constexpr uint64_t autosomes[] = {248956422, 242193529, 198295559, 190214555, 181538259, 170805979, 159345973,
+		145138636, 138394717, 133797422, 135086622, 133275309, 114364328, 107043718, 101991189, 90338345, 83257441,
+		80373285, 58617616, 64444167, 46709983, 50818468};
+	if (chrom.starts_with("chr")) {
+		chrom.remove_prefix(3);
+	}
+	if (chrom == "X") {
+		return 156040895;
+	}
+	if (chrom == "Y") {
+		return 57227415;
+	}
+	if (chrom == "M" || chrom == "MT") {
+		return 16569;
+	}
+	unsigned number = 0;
+	auto const [ptr, ec] = std::from_chars(chrom.data(), chrom.data() + chrom.size(), number);
+	if (ec == std::errc() && ptr == chrom.data() + chrom.size() && number >= 1 && number <= std::size(autosomes)) {
+		return autosomes[number - 1];
+	}
+	return std::nullopt;
+}
+
+// The data line validator of one profile, the checks Checks leaves out are compiled away
+template<DataLineChecks Checks>
+bool checkDataLinesWith(std::string_view line, HeaderModel const *header, RecordOrder *order)
+{
+	ScopedStageTimer timer(StatsStage::DataLines);
+	countStats(StatsCounter::Records, 1);
+
+	// FORMAT field is the 9th column (0-based index), the sample columns stay joined in the field after it
+	size_t const formatFieldIndex = 8;
+	thread_local std::vector<std::string_view> fields;
+	splitFields<'\t'>(line, fields, formatFieldIndex + 2);
+
+	// Basic check for the number of fields
+	size_t const expectedFieldCount = 8;
+	if (fields.size() < expectedFieldCount) {
+		reportError(ErrorCode::NotEnoughFields, line);
+		return false;
+	}
+
+	// Validate CHROM - simple check for non-empty string
+	if (fields[0].empty()) {
+		reportError(ErrorCode::InvalidChrom, fields[0]);
+		return false;
+	}
+
+	// A header with ##contig lines declares every contig; the table also knows whether it is a human chromosome
+	ContigDefinition const *contig = nullptr;
+	if (header != nullptr && !header->contigs().empty()) {
+		contig = header->findContig(fields[0]);
+		if (contig == nullptr) {
+			reportError(ErrorCode::UndeclaredContig, fields[0]);
+			return false;
+		}
+	}
+
+	// Check if CHROM field is a human chromosome
+	if constexpr (Checks.humanChromosomes) {
+		if (contig != nullptr ? !contig->human : !isHumanChromosome(fields[0])) {
+			reportError(ErrorCode::NonHumanChromosome, fields[0]);
+			return false;
+		}
+	}
+
+	// Validate POS - should be a positive integer
+	int pos = 0;
+	try {
+		pos = stringViewToInt(fields[1]);
+		if (pos <= 0) {
+			reportError(ErrorCode::InvalidPos, fields[1]);
+			return false;
+		}
+	} catch (std::invalid_argument &e) {
+		reportError(ErrorCode::PosNotInteger, fields[1]);
+		return false;
+	}
+	std::optional<uint64_t> length = contig != nullptr ? contig->length : std::nullopt;
+	if constexpr (Checks.grch38Lengths) {
+		if (!length) {
+			length = grch38Length(fields[0]);
+		}
+	}
+	if (length && static_cast<uint64_t>(pos) > *length) {
+		reportError(ErrorCode::PosBeyondContigLength, fields[1]);
+		return false;
+	}
+	if (order != nullptr && !order->check(fields[0], static_cast<uint64_t>(pos))) {
+		return false;
+	}
+
+	// Validate ID - should be a string or '.'
+	if constexpr (Checks.valueColumns) {
+		if (fields[2] != "." && fields[2].empty()) {
+			reportError(ErrorCode::InvalidId, fields[2]);
+			return false;
+		}
+	}
+
+	// Validate REF - should be one of A, C, G, T, N
+	if (!isValidBase(fields[3])) {
+		reportError(ErrorCode::InvalidRef, fields[3]);
+		return false;
+	}
+
+	// Validate ALT field, counting its alleles for the Number=A, R and G checks of INFO and the sample columns
+	uint32_t const altAlleles = countAltAlleles(fields[4]); // Assuming ALT is the fifth column (0-based indexing)
+	if (altAlleles == 0) {
+		reportError(ErrorCode::InvalidAlt, fields[4]);
+		return false;
+	}
+
+	if constexpr (Checks.valueColumns) {
+		// Validate QUAL - should be a float or '.'
+		if (number_syntax::isShortDecimal<true>(fields[5])) {
+			if (number_syntax::isNegativeShortDecimal(fields[5])) {
+				reportError(ErrorCode::InvalidQual, fields[5]);
+				return false;
+			}
+		} else if (fields[5] != ".") {
+			try {
+				float qual = stringViewToFloat(fields[5]);
+				if (qual < 0) {
+					reportError(ErrorCode::InvalidQual, fields[5]);
+					return false;
+				}
+			} catch (std::invalid_argument &e) {
+				reportError(ErrorCode::QualNotFloat, fields[5]);
+				return false;
+			}
+		}
+
+		// Validate FILTER - should be a string or '.'
+		if (fields[6] != "." && fields[6].empty()) {
+			reportError(ErrorCode::InvalidFilter, fields[6]);
+			return false;
+		}
+
+		// Validate INFO - additional information in key=value format, typed by the header's ##INFO lines
+		if (fields[7].empty()) {
+			reportError(ErrorCode::InvalidInfo, fields[7]);
+			return false;
+		}
+		if (header != nullptr && !checkInfoField(fields[7], *header, altAlleles)) {
+			return false;
+		}
+	}
+
+	// Check FORMAT and sample-specific columns
+	if constexpr (Checks.samples) {
+		if (!checkFormatAndSamples(fields, formatFieldIndex, header, altAlleles)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+} // namespace
+
+bool checkDataLines(std::string_view line, HeaderModel const *header, RecordOrder *order, ValidationProfile profile)
+{
+	switch (profile) {
+	case ValidationProfile::Structural:
+		return checkDataLinesWith<profileChecks(ValidationProfile::Structural)>(line, header, order);
+	case ValidationProfile::HumanGrch38:
+		return checkDataLinesWith<profileChecks(ValidationProfile::HumanGrch38)>(line, header, order);
+	case ValidationProfile::NonHuman:
+		return checkDataLinesWith<profileChecks(ValidationProfile::NonHuman)>(line, header, order);
+	case ValidationProfile::Strict:
+		break;
+	}
+	return checkDataLinesWith<profileChecks(ValidationProfile::Strict)>(line, header, order);
+}
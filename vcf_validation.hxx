@@ -0,0 +1,68 @@
+#pragma once
+
+#include "validation_profile.hxx"
+
+#include <cstdint>
+#include <iosfwd>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Stream errors are printed to when the calling thread has no ErrorSink installed (error_sink.hxx); std::cerr unless
+// redirected for the calling thread
+std::ostream &diagnostics();
+
+// Redirects diagnostics() of the current thread while in scope
+class DiagnosticsRedirect {
+public:
+	explicit DiagnosticsRedirect(std::ostream &target);
+	~DiagnosticsRedirect();
+
+	DiagnosticsRedirect(DiagnosticsRedirect const &) = delete;
+	DiagnosticsRedirect &operator=(DiagnosticsRedirect const &) = delete;
+
+private:
+	std::ostream *previous;
+};
+
+class HeaderModel;
+class RecordOrder;
+
+// Meta-information and column header lines. With a header, what a valid line declares is added to it.
+bool validateHeaderLine(std::string_view line, HeaderModel *header = nullptr);
+bool validateFileFormatLine(std::string_view line, HeaderModel *header = nullptr);
+bool validateContigLine(std::string_view line, HeaderModel *header = nullptr);
+bool validateAltLine(std::string_view line);
+bool validateSampleOrPedigreeLine(std::string_view line);
+bool checkTitleLine(std::string_view line, HeaderModel *header = nullptr);
+
+// Field level checks used by the data line validator
+// Allocating split for callers off the hot path, see delimiter_scan.hxx for the data line kernels
+std::vector<std::string_view> split(std::string_view str, char delimiter);
+bool isValidAlt(std::string_view alt);
+// Number of alleles in a valid ALT field, 0 if it is invalid
+uint32_t countAltAlleles(std::string_view alt);
+bool isValidBase(std::string_view base);
+bool isValidGenotype(std::string_view gt);
+bool isNonNegativeInteger(std::string_view str);
+bool isListOfNonNegativeIntegers(std::string_view str);
+bool isFloat(std::string_view str);
+bool isBoolean(std::string_view value);
+bool isNumericChromosome(std::string_view chrom);
+bool isHumanChromosome(std::string_view chrom);
+// Throw std::invalid_argument when sv does not start with a number in range
+int stringViewToInt(std::string_view sv);
+float stringViewToFloat(std::string_view sv);
+
+// Data lines, checked against what header declares when one is given, for sorted order with order, and with the
+// checks of profile
+// fields are the columns up to FORMAT; fields[formatIndex + 1], if present, holds all sample columns still joined by
+// tabs. altAlleles, the record's ALT allele count, sets the value counts of keys the header declares Number=A, R or G.
+bool checkFormatAndSamples(std::span<std::string_view const> fields, size_t formatIndex,
+	HeaderModel const *header = nullptr, uint32_t altAlleles = 1);
+bool checkDataLines(std::string_view line, HeaderModel const *header = nullptr, RecordOrder *order = nullptr,
+	ValidationProfile profile = ValidationProfile::Strict);
+// Any line after the column header line: a late meta-information line or a data line
+bool validateBodyLine(std::string_view line, HeaderModel const *header = nullptr, RecordOrder *order = nullptr,
+	ValidationProfile profile = ValidationProfile::Strict);
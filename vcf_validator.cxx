@@ -0,0 +1,113 @@
+#include "vcf_validator.hxx"
+
+#include "vcf_validation.hxx"
+
+#include <cstdint>
+#include <string_view>
+
+namespace {
+
+// Errors one line can report before it is counted as failed
+constexpr size_t lineSinkCapacity = 16;
+
+} // namespace
+
+VcfValidator::VcfValidator(ValidationOptions const &options)
+	: maxErrors(options.maxErrors == 0 ? SIZE_MAX : options.maxErrors)
+	, profile(options.profile)
+	, sink(lineSinkCapacity)
+{
+	headerModel.setSampleSelection(options.samples);
+}
+
+void VcfValidator::feed(std::span<char const> data)
+{
+	if (stop) {
+		return;
+	}
+	std::string_view rest(data.data(), data.size());
+	if (!partialLine.empty()) {
+		size_t const newline = rest.find('\n');
+		partialLine.append(rest.substr(0, newline));
+		if (newline == std::string_view::npos) {
+			return;
+		}
+		validateLine(partialLine);
+		partialLine.clear();
+		rest.remove_prefix(newline + 1);
+	}
+
+	while (!stop) {
+		size_t const newline = rest.find('\n');
+		if (newline == std::string_view::npos) {
+			partialLine.assign(rest);
+			return;
+		}
+		validateLine(rest.substr(0, newline));
+		rest.remove_prefix(newline + 1);
+	}
+}
+
+bool VcfValidator::finish()
+{
+	if (!partialLine.empty() && !stop) {
+		validateLine(partialLine);
+	}
+	partialLine.clear();
+	if (section == Section::Header && !stop) {
+		ErrorSinkScope scope(sink);
+		sink.setLine(0);
+		reportError(ErrorCode::MissingTitleLine);
+		errorList.insert(errorList.end(), sink.errors().begin(), sink.errors().end());
+		sink.clear();
+		stop = true;
+	}
+	return errorList.empty();
+}
+
+void VcfValidator::reset()
+{
+	section = Section::Header;
+	stop = false;
+	lineNumber = 0;
+	failedLines = 0;
+	partialLine.clear();
+	errorList.clear();
+	sink.clear();
+	headerModel.clear();
+	order.clear();
+}
+
+bool VcfValidator::validate(std::span<char const> file)
+{
+	reset();
+	feed(file);
+	return finish();
+}
+
+void VcfValidator::validateLine(std::string_view line)
+{
+	ErrorSinkScope scope(sink);
+	sink.setLine(++lineNumber);
+
+	bool valid = true;
+	if (section == Section::Body) {
+		order.setLine(lineNumber);
+		valid = validateBodyLine(line, &headerModel, &order, profile);
+	} else if (line.starts_with("##")) { // Meta-information lines
+		valid = validateHeaderLine(line, &headerModel);
+	} else if (line.starts_with("#")) { // Column header line
+		valid = checkTitleLine(line, &headerModel);
+		section = Section::Body;
+	} else {
+		reportError(ErrorCode::UnexpectedLine, line);
+		valid = false;
+	}
+	if (valid) {
+		return;
+	}
+
+	errorList.insert(errorList.end(), sink.errors().begin(), sink.errors().end());
+	sink.clear();
+	stop = ++failedLines >= maxErrors;
+}
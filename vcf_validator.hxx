@@ -0,0 +1,68 @@
+#pragma once
+
+#include "error_sink.hxx"
+#include "header_model.hxx"
+#include "record_order.hxx"
+#include "validation_options.hxx"
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+// Validates one VCF at a time from bytes already in memory, on the calling thread: feed() the text in pieces of
+// any size as it arrives, then finish(). Lines are validated in place where they lie within one piece; only a line
+// split across pieces is copied. reset() keeps the buffers, its own and the header model's, so one instance validates
+// the data lines of file after file without allocating once they have grown to size.
+class VcfValidator {
+public:
+	// options.maxErrors, options.profile and options.samples apply, the options for files, threads and regions do not
+	explicit VcfValidator(ValidationOptions const &options = {});
+
+	// Validates the complete lines in data, carrying an incomplete last line over to the next call
+	void feed(std::span<char const> data);
+	// Validates a last line without a newline and checks that the header was complete. Returns whether the file is
+	// valid.
+	bool finish();
+	// Starts the next file
+	void reset();
+	// reset(), feed() and finish() for a whole file
+	bool validate(std::span<char const> file);
+
+	// Invalid lines so far, in input order with their line numbers. Valid until reset(): field and message may
+	// refer to the header model.
+	std::span<ValidationError const> errors() const
+	{
+		return errorList;
+	}
+	// True once maxErrors lines have failed; feed() ignores its input from then on
+	bool stopped() const
+	{
+		return stop;
+	}
+	HeaderModel const &header() const
+	{
+		return headerModel;
+	}
+
+private:
+	enum class Section
+	{
+		Header,
+		Body,
+	};
+
+	size_t maxErrors;
+	ValidationProfile profile;
+	Section section = Section::Header;
+	bool stop = false;
+	uint64_t lineNumber = 0;
+	size_t failedLines = 0;
+	std::string partialLine;
+	std::vector<ValidationError> errorList;
+	ErrorSink sink;
+	HeaderModel headerModel;
+	RecordOrder order;
+
+	void validateLine(std::string_view line);
+};